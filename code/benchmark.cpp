@@ -0,0 +1,181 @@
+/*
+Description:
+Benchmarks (-B): every registered backend on the active rule, then, for
+B3/S23, the kernel as the OMP backend runs it (rows split among the
+threads with an omp simd column loop) against the same rows with the
+plain per-cell column loop it replaced, and against one combined omp
+parallel for simd loop over every cell of the grid.
+*/
+
+#include "life.h"
+#include "rules.h"
+#include "topology.h"
+#include <algorithm>
+#include <omp.h>
+#include <chrono>
+#include <iostream>
+
+// Generations handed to a backend at once, as in headless export between timing reports
+static const int BENCHMARK_BATCH = 100;
+
+/*
+Computes one B3/S23 generation with a single combined construct: the row
+and column loops are collapsed into one iteration space that OpenMP splits
+among the threads, and each thread runs its share in vector lanes.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+
+Returns:
+- void
+*/
+static void updateGridParallelForSimd(const Grid& grid_current, Grid& grid_next) {
+    const uint8_t* in = grid_current.data();
+    uint8_t* out = grid_next.data();
+    const int width = GRID_WIDTH, height = GRID_HEIGHT, pitch = PITCH;
+    #pragma omp parallel for simd collapse(2) schedule(static) num_threads(NUM_THREADS)
+    for (int y = 1; y <= height; ++y) {
+        for (int x = 1; x <= width; ++x) {
+            int idx = y * pitch + x;
+            int neighbors = in[idx - pitch - 1] + in[idx - pitch] + in[idx - pitch + 1]
+                          + in[idx - 1] + in[idx + 1]
+                          + in[idx + pitch - 1] + in[idx + pitch] + in[idx + pitch + 1];
+            out[idx] = in[idx] ? (neighbors == 2 || neighbors == 3) : (neighbors == 3);
+        }
+    }
+}
+
+/*
+Applies B3/S23 to a range of rows one cell at a time, the loop the OMP
+backend ran before its column loop was marked omp simd. Every cell is read
+through the vectors, so the compiler cannot rule out that a store to
+grid_next changes grid_current and keeps the loop scalar.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y_begin: First padded row to compute.
+- y_end: Padded row after the last one to compute.
+
+Returns:
+- void
+*/
+static void updateRowsLifeScalar(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end) {
+    for (int y = y_begin; y < y_end; ++y) {
+        int idx = y * PITCH + 1;  // Calculate starting index for the row
+        for (int x = 1; x <= GRID_WIDTH; ++x, ++idx) {
+            // Count the number of alive neighbors
+            int neighbors = grid_current[idx - PITCH - 1] + grid_current[idx - PITCH] + grid_current[idx - PITCH + 1]
+                          + grid_current[idx - 1] + grid_current[idx + 1]
+                          + grid_current[idx + PITCH - 1] + grid_current[idx + PITCH] + grid_current[idx + PITCH + 1];
+            // Apply the Game of Life rules
+            grid_next[idx] = (grid_current[idx]) ? (neighbors == 2 || neighbors == 3) : (neighbors == 3);
+        }
+    }
+}
+
+/*
+Runs one variant from the seeded grid and prints its time.
+
+Parameters:
+- label: Name printed with the result.
+- thread_label: Kind of threads printed with the thread count, nullptr for one thread.
+- generations: Number of generations to run.
+- seed: Seed of the initial grid.
+- advance: Computes a batch of generations from its first grid into its second.
+
+Returns:
+- Hash of the last generation.
+*/
+template <class Advance>
+static uint64_t runVariant(const char* label, const char* thread_label, int generations, uint64_t seed, Advance advance) {
+    size_t cells = static_cast<size_t>(GRID_HEIGHT + 2) * PITCH;
+    Grid grid_current(cells, 0), grid_next(cells, 0);
+    seedRandomGrid(grid_current, seed);
+    advance(grid_current, grid_next, 1);  // Warm-up generation touches the pages of both grids
+    std::swap(grid_current, grid_next);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int g = 0; g < generations; g += BENCHMARK_BATCH) {
+        advance(grid_current, grid_next, std::min(BENCHMARK_BATCH, generations - g));
+        std::swap(grid_current, grid_next);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    long long delta_t = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+    double mcells = delta_t > 0 ? static_cast<double>(GRID_WIDTH) * GRID_HEIGHT * generations / delta_t : 0;
+    std::cout << label << ": " << generations << " generations took " << delta_t << " microseconds with ";
+    if (thread_label)
+        std::cout << NUM_THREADS << " " << thread_label << ". ";
+    else
+        std::cout << "1 thread. ";
+    std::cout << static_cast<long long>(mcells) << " Mcells/s" << std::endl;
+    return hashGrid(grid_current);
+}
+
+/*
+Times the three variants of the B3/S23 kernel on the current grid size and
+checks that they end in the same grid.
+
+Parameters:
+- generations: Number of generations to time per variant.
+- seed: Seed used for the initial grid.
+
+Returns:
+- true if all variants computed the same grid, false otherwise.
+*/
+bool benchmarkSimd(int generations, uint64_t seed) {
+    auto stepping = [](void (*update)(Grid&, Grid&)) {
+        return [update](Grid& grid_current, Grid& grid_next, int batch) {
+            for (int g = 0; g < batch; ++g) {
+                if (g > 0)
+                    std::swap(grid_current, grid_next);
+                update(grid_current, grid_next);
+            }
+        };
+    };
+    uint64_t scalar = runVariant("OMP rows, scalar columns", "OMP threads", generations, seed, stepping([](Grid& grid_current, Grid& grid_next) {
+        runRowsOMP(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) { updateRowsLifeScalar(grid_current, grid_next, y_begin, y_end); });
+    }));
+    uint64_t rows = runVariant("OMP rows, omp simd columns", "OMP threads", generations, seed, stepping([](Grid& grid_current, Grid& grid_next) {
+        runRowsOMP(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) { updateRowsLife(grid_current, grid_next, y_begin, y_end); });
+    }));
+    uint64_t combined = runVariant("omp parallel for simd", "OMP threads", generations, seed, stepping([](Grid& grid_current, Grid& grid_next) {
+        updateGridParallelForSimd(grid_current, grid_next);
+    }));
+    bool same = scalar == rows && rows == combined;
+    std::cout << (same ? "PASS" : "FAIL") << ": all variants computed the same grid" << std::endl;
+    return same;
+}
+
+/*
+Times every registered backend on the active rule and the current grid
+size, in batches of up to 100 generations the way headless export hands
+them out, and checks that every backend ends in the same grid as the
+first one.
+
+Parameters:
+- generations: Number of generations to time per backend.
+- seed: Seed used for the initial grid.
+
+Returns:
+- true if every backend computed the same grid, false otherwise.
+*/
+bool benchmarkBackends(int generations, uint64_t seed) {
+    std::cout << RULE.name << " on " << GRID_WIDTH << "x" << GRID_HEIGHT << ", CPU: " << describeTopology(cpuTopology()) << std::endl;
+    uint64_t expected = 0;
+    bool same = true;
+    for (int b = 0; b < NUM_BACKENDS; ++b) {
+        const Backend* backend = &BACKENDS[b];
+        uint64_t hash = runVariant(backend->name, backend->thread_label, generations, seed, [backend](Grid& grid_current, Grid& grid_next, int batch) {
+            advanceGrid(backend, grid_current, grid_next, batch);
+        });
+        if (b == 0) {
+            expected = hash;
+        } else if (hash != expected) {
+            std::cout << "FAIL: " << backend->name << " ended in a different grid than " << BACKENDS[0].name << std::endl;
+            same = false;
+        }
+    }
+    return same;
+}
@@ -0,0 +1,152 @@
+/*
+Description:
+Tile based construction of the cell density pyramid.
+*/
+
+#include "density.h"
+#include <algorithm>
+#include <cstring>
+#include <omp.h>
+
+DensityPyramid* TRACKED_DENSITY = nullptr;
+
+/*
+Sizes every level for the current grid dimensions and marks all tiles dirty.
+*/
+void DensityPyramid::resize() {
+    tiles_x = (GRID_WIDTH + TILE_SIZE - 1) / TILE_SIZE;
+    tiles_y = (GRID_HEIGHT + TILE_SIZE - 1) / TILE_SIZE;
+    dirty.reset(new std::atomic<uint8_t>[static_cast<size_t>(tiles_x) * tiles_y]);
+    markAllDirty();
+    level_width[0] = GRID_WIDTH;
+    level_height[0] = GRID_HEIGHT;
+    for (int level = 1; level <= MAX_LEVEL; ++level) {
+        int block = 1 << level;
+        level_width[level] = (GRID_WIDTH + block - 1) / block;
+        level_height[level] = (GRID_HEIGHT + block - 1) / block;
+        levels[level].assign(static_cast<size_t>(level_width[level]) * level_height[level], 0);
+    }
+}
+
+void DensityPyramid::markAllDirty() {
+    for (size_t i = 0; i < static_cast<size_t>(tiles_x) * tiles_y; ++i)
+        dirty[i].store(1, std::memory_order_relaxed);
+}
+
+void DensityPyramid::markDirty(int x, int y) {
+    if (x >= 0 && y >= 0 && x < GRID_WIDTH && y < GRID_HEIGHT)
+        dirty[static_cast<size_t>(y / TILE_SIZE) * tiles_x + x / TILE_SIZE].store(1, std::memory_order_relaxed);
+}
+
+/*
+Compares the computed cells with the previous generation one tile row at a
+time and marks the tiles that changed. Tiles that are already dirty are
+skipped, so a busy tile costs one comparison per generation at most. Bands
+of different threads may share a tile; its flag is only ever set.
+
+Parameters:
+- before: Reference to the previous generation.
+- after: Reference to the generation just computed.
+- y_begin, y_end: Padded rows that were computed.
+- x_begin, x_end: Padded columns that were computed.
+
+Returns:
+- void
+*/
+void DensityPyramid::markChanged(const Grid& before, const Grid& after, int y_begin, int y_end, int x_begin, int x_end) {
+    for (int y = y_begin; y < y_end; ++y) {
+        std::atomic<uint8_t>* row_flags = &dirty[static_cast<size_t>((y - 1) / TILE_SIZE) * tiles_x];
+        for (int x = x_begin; x < x_end;) {
+            int tx = (x - 1) / TILE_SIZE;
+            int stop = std::min(x_end, (tx + 1) * TILE_SIZE + 1);  // First padded column of the next tile
+            size_t at = static_cast<size_t>(y) * PITCH + x;
+            if (!row_flags[tx].load(std::memory_order_relaxed) && std::memcmp(&before[at], &after[at], stop - x) != 0)
+                row_flags[tx].store(1, std::memory_order_relaxed);
+            x = stop;
+        }
+    }
+}
+
+/*
+Rebuilds the dirty tiles that overlap a rectangle of cells. Tiles are
+independent, so they are rebuilt in parallel.
+
+Parameters:
+- grid: Reference to the grid being summarized.
+- x0, y0: First cell column and row of the region (0-based, inclusive).
+- x1, y1: End cell column and row of the region (exclusive).
+
+Returns:
+- void
+*/
+void DensityPyramid::refresh(const Grid& grid, int x0, int y0, int x1, int y1) {
+    int tx0 = std::max(0, x0 / TILE_SIZE), ty0 = std::max(0, y0 / TILE_SIZE);
+    int tx1 = std::min(tiles_x, (x1 + TILE_SIZE - 1) / TILE_SIZE);
+    int ty1 = std::min(tiles_y, (y1 + TILE_SIZE - 1) / TILE_SIZE);
+
+    std::vector<int> stale;  // Indices of the dirty tiles in the region
+    for (int ty = ty0; ty < ty1; ++ty) {
+        for (int tx = tx0; tx < tx1; ++tx) {
+            if (dirty[static_cast<size_t>(ty) * tiles_x + tx].load(std::memory_order_relaxed))
+                stale.push_back(ty * tiles_x + tx);
+        }
+    }
+
+    #pragma omp parallel for schedule(dynamic) num_threads(NUM_THREADS)
+    for (int i = 0; i < static_cast<int>(stale.size()); ++i) {
+        buildTile(grid, stale[i] % tiles_x, stale[i] / tiles_x);
+        dirty[stale[i]].store(0, std::memory_order_relaxed);
+    }
+}
+
+/*
+Recomputes every level inside one tile. Level 1 is summed directly from the
+grid, each higher level averages the four blocks below it. Cells past the
+right and bottom edge of the grid count as dead.
+*/
+void DensityPyramid::buildTile(const Grid& grid, int tx, int ty) {
+    // Level 1: 2x2 blocks of cells
+    int bx0 = tx * TILE_SIZE / 2, by0 = ty * TILE_SIZE / 2;
+    int bx1 = std::min(level_width[1], bx0 + TILE_SIZE / 2);
+    int by1 = std::min(level_height[1], by0 + TILE_SIZE / 2);
+    for (int by = by0; by < by1; ++by) {
+        int y = 2 * by + 1;  // Padded row of the top cells
+        const uint8_t* top = &grid[y * PITCH + 1];
+        const uint8_t* bottom = (y + 1 <= GRID_HEIGHT) ? top + PITCH : nullptr;
+        uint8_t* out = &levels[1][static_cast<size_t>(by) * level_width[1]];
+        for (int bx = bx0; bx < bx1; ++bx) {
+            int x = 2 * bx;
+            // Any non-zero state (live or dying) counts as occupied
+            int count = (top[x] != 0) + ((x + 1 < GRID_WIDTH) ? top[x + 1] != 0 : 0);
+            if (bottom)
+                count += (bottom[x] != 0) + ((x + 1 < GRID_WIDTH) ? bottom[x + 1] != 0 : 0);
+            out[bx] = static_cast<uint8_t>((count * 255 + 2) / 4);
+        }
+    }
+
+    // Levels 2 and up: average of the four child blocks
+    for (int level = 2; level <= MAX_LEVEL; ++level) {
+        int span = TILE_SIZE >> level;  // Blocks per tile side at this level
+        int cw = level_width[level - 1], ch = level_height[level - 1];
+        const std::vector<uint8_t>& child = levels[level - 1];
+        bx0 = tx * span;
+        by0 = ty * span;
+        bx1 = std::min(level_width[level], bx0 + span);
+        by1 = std::min(level_height[level], by0 + span);
+        for (int by = by0; by < by1; ++by) {
+            uint8_t* out = &levels[level][static_cast<size_t>(by) * level_width[level]];
+            for (int bx = bx0; bx < bx1; ++bx) {
+                int sum = 0;
+                for (int dy = 0; dy < 2; ++dy) {
+                    int cy = 2 * by + dy;
+                    for (int dx = 0; dx < 2 && cy < ch; ++dx) {
+                        int cx = 2 * bx + dx;
+                        if (cx < cw)
+                            sum += child[static_cast<size_t>(cy) * cw + cx];
+                    }
+                }
+                out[bx] = static_cast<uint8_t>((sum + 2) / 4);
+            }
+        }
+    }
+}
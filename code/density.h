@@ -0,0 +1,66 @@
+/*
+Description:
+Multi-level cell density summaries used to draw large grids when zoomed out.
+*/
+
+#ifndef DENSITY_H
+#define DENSITY_H
+
+#include "life.h"
+#include <atomic>
+#include <memory>
+
+/*
+Level l (1..MAX_LEVEL) stores one byte per 2^l x 2^l block of cells holding
+the fraction of live cells scaled to 0..255. The grid is divided into
+TILE_SIZE x TILE_SIZE tiles that are rebuilt independently, so after an edit
+or a generation only dirty tiles in the region being drawn are recomputed.
+The rule kernels mark the tiles whose cells they changed while the rows are
+still in cache, so still life and empty space are never rebuilt.
+*/
+class DensityPyramid {
+public:
+    static const int TILE_SIZE = 64;  // Cells per tile side, equal to the block size of the top level
+    static const int MAX_LEVEL = 6;
+
+    // Sizes the levels for the current GRID_WIDTH x GRID_HEIGHT and marks every tile dirty
+    void resize();
+
+    // Marks every tile as stale, for changes the kernels do not report: a rewind, a slice change or a resize.
+    // Generations are reported tile by tile through TRACKED_DENSITY and must not call this
+    void markAllDirty();
+
+    // Marks the tile containing cell (x, y) as stale, coordinates are 0-based
+    void markDirty(int x, int y);
+
+    // Marks the tiles whose cells differ between the grids in padded rows [y_begin, y_end) and columns [x_begin, x_end); thread-safe
+    void markChanged(const Grid& before, const Grid& after, int y_begin, int y_end, int x_begin, int x_end);
+
+    // Rebuilds the dirty tiles overlapping the cell rectangle [x0, x1) x [y0, y1)
+    void refresh(const Grid& grid, int x0, int y0, int x1, int y1);
+
+    int width(int level) const { return level_width[level]; }
+    int height(int level) const { return level_height[level]; }
+    const uint8_t* row(int level, int y) const { return &levels[level][static_cast<size_t>(y) * level_width[level]]; }
+
+private:
+    void buildTile(const Grid& grid, int tx, int ty);
+
+    int tiles_x = 0, tiles_y = 0;
+    std::unique_ptr<std::atomic<uint8_t>[]> dirty;  // One flag per tile, set by the kernel threads
+    std::vector<uint8_t> levels[MAX_LEVEL + 1]; // Index 0 is unused, the grid itself is level 0
+    int level_width[MAX_LEVEL + 1] = {};
+    int level_height[MAX_LEVEL + 1] = {};
+};
+
+// Pyramid told which tiles each generation changed, null when nothing is drawn (headless runs)
+extern DensityPyramid* TRACKED_DENSITY;
+
+// Called by the rule kernels on the cells they computed; marks the changed tiles of TRACKED_DENSITY
+inline void reportChangedCells(const Grid& before, const Grid& after, int y_begin, int y_end,
+                               int x_begin = 1, int x_end = GRID_WIDTH + 1) {
+    if (TRACKED_DENSITY)
+        TRACKED_DENSITY->markChanged(before, after, y_begin, y_end, x_begin, x_end);
+}
+
+#endif
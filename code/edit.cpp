@@ -0,0 +1,117 @@
+/*
+Description:
+Queued cell edits.
+*/
+
+#include "edit.h"
+#include <climits>
+#include <cstdlib>
+#include <algorithm>
+
+/*
+Queues a brush stroke. Only the end points are stored; the covered cells
+are filled in by apply(), so a long drag with a large brush costs one entry.
+
+Parameters:
+- x0, y0: Start cell of the stroke.
+- x1, y1: End cell of the stroke.
+- state: State written to every covered cell.
+- brush: Side of the square brush in cells.
+
+Returns:
+- void
+*/
+void EditQueue::pushStroke(int x0, int y0, int x1, int y1, uint8_t state, int brush) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.push_back(BrushStroke{x0, y0, x1, y1, std::max(1, brush), state});
+    has_pending = true;
+}
+
+/*
+Fills the cells a square brush covers while it is moved along a line, each
+cell once. The line is walked with Bresenham's algorithm so fast mouse
+drags do not leave gaps, recording the first and last column it visits in
+every row. The brush placed on the line points of a run of consecutive
+rows covers one contiguous span of columns in each grid row, because the
+columns of consecutive line points differ by at most one.
+
+Parameters:
+- stroke: Stroke to fill in.
+- grid: Reference to the current grid state.
+- density: Density pyramid whose tiles are marked dirty for every edited cell.
+
+Returns:
+- Number of cells written.
+*/
+static int fillStroke(const BrushStroke& stroke, Grid& grid, DensityPyramid& density) {
+    int x0 = stroke.x0, y0 = stroke.y0, x1 = stroke.x1, y1 = stroke.y1;
+    int line_top = std::min(y0, y1), line_rows = std::abs(y1 - y0) + 1;
+    std::vector<int> first(line_rows, INT_MAX), last(line_rows, INT_MIN);  // Columns of the line in each of its rows
+    int dx = std::abs(x1 - x0), dy = -std::abs(y1 - y0);
+    int sx = x0 < x1 ? 1 : -1, sy = y0 < y1 ? 1 : -1;
+    int error = dx + dy;
+    for (;;) {
+        first[y0 - line_top] = std::min(first[y0 - line_top], x0);
+        last[y0 - line_top] = std::max(last[y0 - line_top], x0);
+        if (x0 == x1 && y0 == y1)
+            break;
+        int e2 = 2 * error;
+        if (e2 >= dy) {
+            error += dy;
+            x0 += sx;
+        }
+        if (e2 <= dx) {
+            error += dx;
+            y0 += sy;
+        }
+    }
+
+    int brush = stroke.brush;
+    int offset = (brush - 1) / 2;  // Center the brush on the stroke
+    int y_begin = std::max(0, line_top - offset), y_end = std::min(GRID_HEIGHT, line_top + line_rows - offset + brush - 1);
+    int count = 0;
+    for (int y = y_begin; y < y_end; ++y) {
+        // Line rows whose brush square reaches grid row y
+        int row_begin = std::max(0, y + offset - brush + 1 - line_top), row_end = std::min(line_rows, y + offset + 1 - line_top);
+        int left = INT_MAX, right = INT_MIN;
+        for (int row = row_begin; row < row_end; ++row) {
+            left = std::min(left, first[row]);
+            right = std::max(right, last[row]);
+        }
+        int x_begin = std::max(0, left - offset), x_end = std::min(GRID_WIDTH, right - offset + brush);
+        if (x_begin >= x_end)
+            continue;
+        std::fill(&grid[(y + 1) * PITCH + 1 + x_begin], &grid[(y + 1) * PITCH + 1 + x_end], stroke.state);
+        for (int x = x_begin; x < x_end; x += DensityPyramid::TILE_SIZE - x % DensityPyramid::TILE_SIZE)
+            density.markDirty(x, y);  // Once per tile the row crosses
+        count += x_end - x_begin;
+    }
+    return count;
+}
+
+/*
+Writes all queued strokes into the grid, clipped to its bounds. Called by
+the simulation loop between generations, while no backend is reading or
+writing the grid.
+
+Parameters:
+- grid: Reference to the current grid state.
+- density: Density pyramid whose tiles are marked dirty for every edited cell.
+
+Returns:
+- Number of cells written.
+*/
+int EditQueue::apply(Grid& grid, DensityPyramid& density) {
+    if (!has_pending)
+        return 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        applying.swap(pending);
+        has_pending = false;
+    }
+    int count = 0;
+    for (const BrushStroke& stroke : applying)
+        count += fillStroke(stroke, grid, density);  // Clipping also drops strokes queued before a grid resize
+    applying.clear();
+    return count;
+}
@@ -0,0 +1,44 @@
+/*
+Description:
+Queue of cell edits (painting and erasing) applied between generations.
+*/
+
+#ifndef EDIT_H
+#define EDIT_H
+
+#include "life.h"
+#include "density.h"
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+struct BrushStroke {
+    int x0, y0, x1, y1;  // End cells of the line, 0-based, may lie outside the grid
+    int brush;           // Side of the square brush in cells
+    uint8_t state;       // New state of every covered cell
+};
+
+/*
+Edits can be queued from any thread. The simulation loop applies them to the
+current grid between generations and marks the affected density tiles dirty,
+so nothing else has to rescan the grid to pick them up.
+*/
+class EditQueue {
+public:
+    // Queues a square brush of the given size dragged along the line from (x0, y0) to (x1, y1)
+    void pushStroke(int x0, int y0, int x1, int y1, uint8_t state, int brush);
+
+    // True if apply() has edits to write
+    bool hasPending() const { return has_pending; }
+
+    // Applies and clears all queued edits, returning how many cells were written
+    int apply(Grid& grid, DensityPyramid& density);
+
+private:
+    std::mutex mutex;
+    std::vector<BrushStroke> pending;
+    std::vector<BrushStroke> applying;          // Swapped with pending so the lock is held only briefly
+    std::atomic<bool> has_pending{false};    // Lets apply() skip the lock when nothing is queued
+};
+
+#endif
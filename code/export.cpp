@@ -0,0 +1,383 @@
+/*
+Description:
+Y4M and PNG frame export with a pool of encoder threads.
+*/
+
+#include "export.h"
+#include "rules.h"
+#include <cstdio>
+#include <algorithm>
+#include <iostream>
+#include <cctype>
+
+/*
+Computes the CRC-32 used by PNG chunks.
+*/
+static uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    // Built once on first use; function-local static initialization is thread safe
+    static const std::vector<uint32_t> table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k)
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i)
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+static void putBigEndian32(std::vector<uint8_t>& out, uint32_t value) {
+    out.push_back(value >> 24);
+    out.push_back(value >> 16);
+    out.push_back(value >> 8);
+    out.push_back(value);
+}
+
+/*
+Appends a PNG chunk (length, type, data, CRC) to the output buffer.
+*/
+static void putChunk(std::vector<uint8_t>& out, const char* type, const std::vector<uint8_t>& data) {
+    putBigEndian32(out, static_cast<uint32_t>(data.size()));
+    size_t type_start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    putBigEndian32(out, crc32(&out[type_start], data.size() + 4));
+}
+
+/*
+Encodes an 8-bit grayscale image as a PNG file.
+The image data is wrapped in stored (uncompressed) deflate blocks, which keeps
+encoding a single pass over the pixels.
+
+Parameters:
+- pixels: Row-major grayscale pixels, width * height bytes.
+- width: Image width in pixels.
+- height: Image height in pixels.
+
+Returns:
+- The complete PNG file contents.
+*/
+std::vector<uint8_t> encodePNG(const uint8_t* pixels, int width, int height) {
+    static const uint8_t signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    std::vector<uint8_t> out(signature, signature + 8);
+
+    std::vector<uint8_t> header;
+    putBigEndian32(header, width);
+    putBigEndian32(header, height);
+    header.push_back(8);  // Bit depth
+    header.push_back(0);  // Color type: grayscale
+    header.push_back(0);  // Compression method
+    header.push_back(0);  // Filter method
+    header.push_back(0);  // No interlace
+    putChunk(out, "IHDR", header);
+
+    // Raw scanlines, each prefixed with filter type 0
+    size_t row_bytes = static_cast<size_t>(width) + 1;
+    size_t raw_size = row_bytes * height;
+
+    std::vector<uint8_t> data;
+    data.reserve(raw_size + raw_size / 65535 * 5 + 16);
+    data.push_back(0x78);  // zlib header: deflate, 32K window
+    data.push_back(0x01);
+    uint32_t adler_a = 1, adler_b = 0;
+    size_t written = 0;
+    int y = 0, x = -1;  // Position in the filtered scanline stream, x == -1 is the filter byte
+    while (written < raw_size || raw_size == 0) {
+        size_t block = std::min<size_t>(65535, raw_size - written);
+        bool last = written + block == raw_size;
+        data.push_back(last ? 1 : 0);  // Stored block header
+        data.push_back(block & 0xFF);
+        data.push_back(block >> 8);
+        data.push_back(~block & 0xFF);
+        data.push_back((~block >> 8) & 0xFF);
+        for (size_t i = 0; i < block; ++i) {
+            uint8_t byte = (x < 0) ? 0 : pixels[static_cast<size_t>(y) * width + x];
+            if (++x == width) {
+                x = -1;
+                ++y;
+            }
+            data.push_back(byte);
+            adler_a = (adler_a + byte) % 65521;
+            adler_b = (adler_b + adler_a) % 65521;
+        }
+        written += block;
+        if (last)
+            break;
+    }
+    putBigEndian32(data, (adler_b << 16) | adler_a);
+    putChunk(out, "IDAT", data);
+    putChunk(out, "IEND", std::vector<uint8_t>());
+    return out;
+}
+
+/*
+Writes a checkpoint: a binary PGM (P5) whose gray values are the raw cell
+states, so it opens in image viewers and reads back exactly. The rule and
+generation are kept in a comment line.
+
+Parameters:
+- path: File to write.
+- grid: Reference to the padded grid.
+- width: Cells per row of the grid.
+- height: Rows of the grid.
+- generation: Generation number of the grid.
+
+Returns:
+- true if the file was written, false otherwise.
+*/
+bool writeCheckpoint(const std::string& path, const Grid& grid, int width, int height, long long generation) {
+    std::ofstream file(path, std::ios::binary);
+    file << "P5\n# Lab2 rule " << RULE.name << " generation " << generation << "\n" << width << " " << height << "\n255\n";
+    for (int y = 0; y < height; ++y)
+        file.write(reinterpret_cast<const char*>(&grid[static_cast<size_t>(y + 1) * (width + 2) + 1]), width);
+    return static_cast<bool>(file);
+}
+
+/*
+Reads the next number of a PGM header, skipping whitespace and comments.
+The rule of a "# Lab2 rule <rule> generation <n>" comment is kept in rule.
+*/
+static bool readHeaderNumber(std::istream& in, int& value, std::string& rule) {
+    static const std::string RULE_TAG = "# Lab2 rule ";
+    while (true) {
+        int c = in.peek();
+        if (c == '#') {
+            std::string comment;
+            std::getline(in, comment);
+            if (comment.compare(0, RULE_TAG.size(), RULE_TAG) == 0)
+                rule = comment.substr(RULE_TAG.size(), comment.rfind(" generation ") - RULE_TAG.size());
+        } else if (std::isspace(c))
+            in.get();
+        else
+            break;
+    }
+    return static_cast<bool>(in >> value);
+}
+
+/*
+Reads a checkpoint written by writeCheckpoint (or any 8-bit binary PGM). The
+cells are not checked against any rule; see checkCheckpointRule.
+
+Parameters:
+- path: File to read.
+- cells: Reference to the vector receiving width * height cells without padding.
+- width: Reference receiving the number of cells per row.
+- height: Reference receiving the number of rows.
+- rule: Reference receiving the rule written by writeCheckpoint, empty for other PGM files.
+
+Returns:
+- true if the file was a complete 8-bit binary PGM, false otherwise.
+*/
+bool readCheckpoint(const std::string& path, std::vector<uint8_t>& cells, int& width, int& height, std::string& rule) {
+    std::ifstream file(path, std::ios::binary);
+    char magic[2] = {0, 0};
+    int max_value = 0;
+    rule.clear();
+    if (!file.read(magic, 2) || magic[0] != 'P' || magic[1] != '5' || !readHeaderNumber(file, width, rule) ||
+        !readHeaderNumber(file, height, rule) || !readHeaderNumber(file, max_value, rule) || width <= 0 || height <= 0 || max_value != 255)
+        return false;
+    file.get();  // Single whitespace before the cells
+    cells.resize(static_cast<size_t>(width) * height);
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(cells.data()), cells.size()));
+}
+
+/*
+Checks that checkpoint cells can be loaded under the active rule. Discrete
+kernels index their transition tables by the cell state, so a value outside
+the rule's states would read past the table.
+
+Parameters:
+- cells: Unpadded cells read by readCheckpoint.
+- width: Cells per row.
+- rule: Rule named in the checkpoint, empty if it names none.
+- error: Reference receiving the reason when the check fails.
+
+Returns:
+- true if the cells fit the active rule, false otherwise.
+*/
+bool checkCheckpointRule(const std::vector<uint8_t>& cells, int width, const std::string& rule, std::string& error) {
+    if (!rule.empty() && rule != RULE.name) {
+        error = "it was written for rule " + rule + ", not " + RULE.name + " (start it with -r " + rule + ")";
+        return false;
+    }
+    if (RULE.continuous)
+        return true;  // Every byte is a Lenia level
+    for (size_t i = 0; i < cells.size(); ++i) {
+        if (cells[i] >= RULE.states) {
+            error = "cell (" + std::to_string(i % width) + ", " + std::to_string(i / width) + ") holds state " +
+                    std::to_string(cells[i]) + ", but " + RULE.name + " has " + std::to_string(RULE.states) + " states";
+            return false;
+        }
+    }
+    return true;
+}
+
+FrameExporter::FrameExporter(const std::string& path, int scale, int num_threads)
+    : path(path), scale(std::max(1, scale)), width(GRID_WIDTH), height(GRID_HEIGHT) {
+    y4m = path.size() >= 4 && path.compare(path.size() - 4, 4, ".y4m") == 0;
+    num_threads = std::max(1, num_threads);
+    max_queued = 2 * num_threads;
+
+    if (y4m) {
+        stream.open(path, std::ios::binary);
+        if (!stream) {
+            std::cerr << "Cannot open " << path << " for writing." << std::endl;
+            failed = true;
+        }
+        // Monochrome stream, one luma sample per pixel
+        stream << "YUV4MPEG2 W" << width * this->scale << " H" << height * this->scale
+               << " F30:1 Ip A1:1 Cmono\n";
+    }
+
+    for (int i = 0; i < num_threads; ++i)
+        workers.emplace_back(&FrameExporter::worker, this);
+}
+
+FrameExporter::~FrameExporter() {
+    finish();
+}
+
+/*
+Copies the interior of the grid into a frame buffer and queues it for the
+encoder threads. Blocks while the maximum number of frames is in flight so a
+slow disk cannot make memory grow without bound.
+
+Parameters:
+- grid: Reference to the grid to export.
+- generation: Generation number of the grid.
+
+Returns:
+- void
+*/
+void FrameExporter::submit(const Grid& grid, int generation) {
+    std::unique_lock<std::mutex> lock(queue_mutex);
+    queue_space.wait(lock, [this] { return in_flight < max_queued; });
+
+    Frame frame;
+    frame.sequence = next_sequence++;
+    frame.generation = generation;
+    if (!spare.empty()) {
+        frame.cells.swap(spare.back());
+        spare.pop_back();
+    }
+    ++in_flight;
+    lock.unlock();
+
+    // Copy outside the lock so encoders are not held up by the simulation thread
+    frame.cells.resize(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y)
+        std::copy(&grid[(y + 1) * PITCH + 1], &grid[(y + 1) * PITCH + 1] + width, &frame.cells[static_cast<size_t>(y) * width]);
+
+    lock.lock();
+    queue.push_back(std::move(frame));
+    lock.unlock();
+    queue_ready.notify_one();
+}
+
+/*
+Waits for the queue to drain, stops the encoder threads and closes the stream.
+*/
+void FrameExporter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(queue_mutex);
+        if (stopping)
+            return;
+        stopping = true;
+    }
+    queue_ready.notify_all();
+    for (auto& t : workers)
+        t.join();
+    workers.clear();
+    if (stream.is_open())
+        stream.close();
+}
+
+/*
+Encoder thread loop: takes frames from the queue, rasterizes and encodes them,
+then writes the result.
+*/
+void FrameExporter::worker() {
+    for (;;) {
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(queue_mutex);
+            queue_ready.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;  // Stopping and nothing left to encode
+            frame = std::move(queue.front());
+            queue.pop_front();
+        }
+
+        if (y4m) {
+            static const char marker[] = "FRAME\n";
+            std::vector<uint8_t> pixels = rasterize(frame, 6);  // Leave room for the frame marker
+            std::copy(marker, marker + 6, pixels.begin());
+            writeInOrder(frame.sequence, pixels);
+        } else {
+            std::vector<uint8_t> pixels = rasterize(frame, 0);
+            std::vector<uint8_t> png = encodePNG(pixels.data(), width * scale, height * scale);
+            char name[32];
+            std::snprintf(name, sizeof(name), "_%06d.png", frame.generation);
+            std::ofstream file(path + name, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(png.data()), png.size());
+            std::lock_guard<std::mutex> lock(write_mutex);
+            if (!file) {
+                if (!failed)
+                    std::cerr << "Cannot write " << path + name << std::endl;
+                failed = true;
+            }
+            ++frames_written;
+        }
+
+        // Return the cell buffer for reuse and free the slot
+        {
+            std::lock_guard<std::mutex> lock(queue_mutex);
+            spare.push_back(std::move(frame.cells));
+            --in_flight;
+        }
+        queue_space.notify_one();
+    }
+}
+
+/*
+Expands each cell of a frame into a scale x scale block of pixels shaded by
+its state (white alive, black dead, gray dying), after the given number of
+header bytes.
+*/
+std::vector<uint8_t> FrameExporter::rasterize(const Frame& frame, size_t offset) const {
+    int out_width = width * scale;
+    std::vector<uint8_t> pixels(offset + static_cast<size_t>(out_width) * height * scale);
+    for (int y = 0; y < height; ++y) {
+        uint8_t* row = &pixels[offset + static_cast<size_t>(y) * scale * out_width];
+        const uint8_t* cells = &frame.cells[static_cast<size_t>(y) * width];
+        for (int x = 0; x < width; ++x)
+            std::fill(row + x * scale, row + (x + 1) * scale, stateShade(cells[x]));
+        for (int r = 1; r < scale; ++r)
+            std::copy(row, row + out_width, row + static_cast<size_t>(r) * out_width);  // Repeat the scanline
+    }
+    return pixels;
+}
+
+/*
+Writes an encoded Y4M frame once every earlier frame has been written,
+holding later frames back until their turn.
+*/
+void FrameExporter::writeInOrder(int sequence, std::vector<uint8_t>& bytes) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    pending[sequence].swap(bytes);
+    for (auto it = pending.find(next_to_write); it != pending.end(); it = pending.find(next_to_write)) {
+        stream.write(reinterpret_cast<const char*>(it->second.data()), it->second.size());
+        if (!stream && !failed) {
+            std::cerr << "Cannot write " << path << std::endl;
+            failed = true;
+        }
+        pending.erase(it);
+        ++next_to_write;
+        ++frames_written;
+    }
+}
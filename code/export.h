@@ -0,0 +1,89 @@
+/*
+Description:
+Headless frame export. Generations are copied out of the simulation loop and
+encoded by a pool of worker threads into a Y4M stream or a PNG sequence.
+Checkpoints store the raw cell states of one generation.
+*/
+
+#ifndef EXPORT_H
+#define EXPORT_H
+
+#include "life.h"
+#include <string>
+#include <vector>
+#include <map>
+#include <atomic>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <fstream>
+
+// Encodes an 8-bit grayscale image as a PNG file (stored deflate blocks, no compression)
+std::vector<uint8_t> encodePNG(const uint8_t* pixels, int width, int height);
+
+// Writes the interior of a padded grid as a binary PGM holding the raw cell states
+bool writeCheckpoint(const std::string& path, const Grid& grid, int width, int height, long long generation);
+
+// Reads a checkpoint into unpadded cells, its size and the rule it was written for (empty if unknown)
+bool readCheckpoint(const std::string& path, std::vector<uint8_t>& cells, int& width, int& height, std::string& rule);
+
+// Checks checkpoint cells against the active rule: matching rule name and no state outside the rule
+bool checkCheckpointRule(const std::vector<uint8_t>& cells, int width, const std::string& rule, std::string& error);
+
+class FrameExporter {
+public:
+    /*
+    Opens the export target and starts the encoder threads.
+    Paths ending in .y4m produce a single stream, anything else is used as
+    the prefix of a numbered PNG sequence (prefix_000000.png, ...).
+    */
+    FrameExporter(const std::string& path, int scale, int num_threads);
+    ~FrameExporter();
+
+    // Copies the interior of the grid and queues it for encoding (blocks when the queue is full)
+    void submit(const Grid& grid, int generation);
+
+    // Waits for all queued frames to be encoded and written, then stops the workers
+    void finish();
+
+    // Safe to call from any thread while the encoders run
+    bool ok() const { return !failed.load(std::memory_order_relaxed); }
+    int framesWritten() const { return frames_written.load(std::memory_order_relaxed); }
+
+private:
+    struct Frame {
+        int sequence;                // Submission order, used to keep the Y4M stream ordered
+        int generation;              // Generation number, used for PNG file names
+        std::vector<uint8_t> cells;  // GRID_WIDTH x GRID_HEIGHT cells without padding
+    };
+
+    void worker();
+    std::vector<uint8_t> rasterize(const Frame& frame, size_t offset) const;
+    void writeInOrder(int sequence, std::vector<uint8_t>& bytes);
+
+    std::string path;
+    bool y4m;                   // Single Y4M stream instead of a PNG sequence
+    int scale;                  // Output pixels per cell
+    int width, height;          // Grid size captured at construction
+    size_t max_queued;          // Frames allowed in flight before submit blocks
+
+    std::vector<std::thread> workers;
+    std::deque<Frame> queue;    // Frames waiting for an encoder
+    std::vector<std::vector<uint8_t>> spare;  // Reusable cell buffers
+    std::mutex queue_mutex;
+    std::condition_variable queue_ready;   // Signals workers that a frame is queued
+    std::condition_variable queue_space;   // Signals submit that a slot was freed
+    size_t in_flight = 0;
+    bool stopping = false;
+    int next_sequence = 0;
+
+    std::ofstream stream;       // Y4M output
+    std::mutex write_mutex;
+    std::map<int, std::vector<uint8_t>> pending;  // Encoded Y4M frames waiting for their turn
+    int next_to_write = 0;
+    std::atomic<int> frames_written{0};  // Written under write_mutex, read without it
+    std::atomic<bool> failed{false};
+};
+
+#endif
@@ -0,0 +1,108 @@
+/*
+Description:
+Headless export as a TBB flow graph of update, statistics and render nodes.
+*/
+
+#ifdef LAB2_TBB
+
+#include "pipeline.h"
+#include <tbb/flow_graph.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+// Grids used by the flow graph; generation g lives in grids[g % FLOW_GRIDS]
+static const int FLOW_GRIDS = 4;
+
+/*
+Exports the given number of generations like the serial headless loop, as
+a flow graph:
+- update: an input node that computes the generations in order, each from
+  the one before.
+- stats: a serial node that adds up the kernel times and reports every 100
+  generations.
+- render: a serial node that publishes the snapshot and hands every Nth
+  generation to the exporter.
+A limiter node between update and stats lets at most FLOW_GRIDS - 2
+generations into the later stages, and render releases each one when it is
+done. With the generation being stepped and the one it starts from, that
+keeps update from overwriting a grid the later stages still read.
+
+Parameters:
+- backend: Backend that computes the generations.
+- initial: Reference to the grid of generation 0.
+- exporter: Reference to the frame exporter.
+- snapshots: Reference to the snapshot publisher.
+- generations: Number of generations to compute.
+- export_every: Export every Nth generation.
+- report: Called with the timing of every 100 generations.
+
+Returns:
+- true if every frame was exported, false if the exporter failed.
+*/
+bool runFlowGraphExport(const Backend* backend, const Grid& initial, FrameExporter& exporter, SnapshotPublisher& snapshots,
+                        int generations, int export_every, const TimingReport& report) {
+    std::vector<Grid> grids(FLOW_GRIDS, initial);
+    long long kernel_us[FLOW_GRIDS] = {};  // Step time of the generation in each grid
+    std::atomic<bool> failed(false);        // The exporter failed, no more generations are computed
+
+    exporter.submit(grids[0], 0);
+    snapshots.publish(grids[0], 0, true);
+
+    tbb::flow::graph graph;
+    int next_generation = 1;
+    tbb::flow::input_node<int> update(graph, [&](tbb::flow_control& control) -> int {
+        if (next_generation > generations || failed.load(std::memory_order_relaxed)) {
+            control.stop();
+            return 0;
+        }
+        int generation = next_generation++;
+        auto start = std::chrono::high_resolution_clock::now();
+        updateGrid(backend, grids[(generation - 1) % FLOW_GRIDS], grids[generation % FLOW_GRIDS]);
+        auto end = std::chrono::high_resolution_clock::now();
+        kernel_us[generation % FLOW_GRIDS] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+        return generation;
+    });
+
+    tbb::flow::limiter_node<int> in_flight(graph, FLOW_GRIDS - 2);
+
+    long long delta_t = 0;
+    int generation_count = 0, frame_count = 0;
+    auto report_start = std::chrono::high_resolution_clock::now();
+    tbb::flow::function_node<int, int> stats(graph, tbb::flow::serial, [&](int generation) {
+        delta_t += kernel_us[generation % FLOW_GRIDS];
+        if (generation % export_every == 0)
+            frame_count++;
+        if (++generation_count == 100) {
+            auto end = std::chrono::high_resolution_clock::now();
+            report(delta_t, std::chrono::duration<double>(end - report_start).count(), frame_count);
+            generation_count = 0;
+            delta_t = 0;
+            frame_count = 0;
+            report_start = end;
+        }
+        return generation;
+    });
+
+    tbb::flow::function_node<int, tbb::flow::continue_msg> render(graph, tbb::flow::serial, [&](int generation) {
+        const Grid& grid = grids[generation % FLOW_GRIDS];
+        snapshots.publish(grid, generation, generation % export_every == 0);
+        if (generation % export_every == 0 && !failed.load(std::memory_order_relaxed)) {
+            exporter.submit(grid, generation);
+            if (!exporter.ok())
+                failed = true;
+        }
+        return tbb::flow::continue_msg();
+    });
+
+    tbb::flow::make_edge(update, in_flight);
+    tbb::flow::make_edge(in_flight, stats);
+    tbb::flow::make_edge(stats, render);
+    tbb::flow::make_edge(render, in_flight.decrementer());
+
+    update.activate();
+    graph.wait_for_all();
+    return !failed;
+}
+
+#endif
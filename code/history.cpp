@@ -0,0 +1,165 @@
+/*
+Description:
+XOR delta history with run-length coding.
+*/
+
+#include "history.h"
+#include <algorithm>
+#include <omp.h>
+
+// Appends an unsigned LEB128 varint
+static void putVarint(std::vector<uint8_t>& out, size_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<uint8_t>(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+static size_t getVarint(const uint8_t*& in) {
+    size_t value = 0;
+    for (int shift = 0;; shift += 7) {
+        uint8_t byte = *in++;
+        value |= static_cast<size_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+// First padded row of a band when the rows are split evenly
+static int bandRow(int band, int num_bands) {
+    return 1 + static_cast<int>(static_cast<long long>(GRID_HEIGHT) * band / num_bands);
+}
+
+History::History(int capacity) : capacity(std::max(1, capacity)), ring(this->capacity) {}
+
+/*
+Encodes the XOR of two consecutive generations. Each band is a sequence of
+records (zero run length, literal count, literal bytes) walking the interior
+cells in row-major order; runs may cross row boundaries.
+
+Parameters:
+- before_edits: Reference to the earlier generation, replaced by the saved base if it was edited.
+- after: Reference to the generation that followed it.
+
+Returns:
+- void
+*/
+void History::record(const Grid& before_edits, const Grid& after) {
+    const Grid& before = edited ? base : before_edits;
+    edited = false;
+    Delta& delta = ring[head];
+    int num_bands = std::max(1, std::min(NUM_THREADS, GRID_HEIGHT));
+    delta.bands.resize(num_bands);
+
+    #pragma omp parallel for schedule(static) num_threads(num_bands)
+    for (int band = 0; band < num_bands; ++band) {
+        std::vector<uint8_t>& out = delta.bands[band];
+        out.clear();  // Keeps the capacity from the entry this slot held before
+        std::vector<uint8_t> literals;
+        size_t zeros = 0;
+        for (int y = bandRow(band, num_bands); y < bandRow(band + 1, num_bands); ++y) {
+            const uint8_t* a = &before[y * PITCH + 1];
+            const uint8_t* b = &after[y * PITCH + 1];
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                uint8_t diff = a[x] ^ b[x];
+                if (diff) {
+                    literals.push_back(diff);
+                } else {
+                    if (!literals.empty()) {
+                        putVarint(out, zeros);
+                        putVarint(out, literals.size());
+                        out.insert(out.end(), literals.begin(), literals.end());
+                        literals.clear();
+                        zeros = 0;
+                    }
+                    ++zeros;
+                }
+            }
+        }
+        if (!literals.empty()) {
+            putVarint(out, zeros);
+            putVarint(out, literals.size());
+            out.insert(out.end(), literals.begin(), literals.end());
+        }
+    }
+
+    head = (head + 1) % capacity;
+    count = std::min(count + 1, capacity);
+}
+
+/*
+Copies the grid before the first edit since the last recorded generation.
+Later edits of the same generation keep the first copy.
+
+Parameters:
+- grid: Reference to the current grid, not yet edited.
+
+Returns:
+- void
+*/
+void History::saveBase(const Grid& grid) {
+    if (edited)
+        return;
+    base.assign(grid.begin(), grid.end());
+    edited = true;
+}
+
+/*
+Applies the newest recorded delta to the grid and drops it from the ring.
+Edits made since that generation are discarded with it.
+
+Parameters:
+- grid: Reference to the grid holding the generation the delta led to.
+
+Returns:
+- true if a generation was restored, false if the history is empty.
+*/
+bool History::rewind(Grid& grid) {
+    if (count == 0)
+        return false;
+    if (edited) {
+        std::copy(base.begin(), base.end(), grid.begin());  // Undo the edits before stepping back
+        edited = false;
+    }
+    head = (head + capacity - 1) % capacity;
+    --count;
+    const Delta& delta = ring[head];
+    int num_bands = static_cast<int>(delta.bands.size());
+
+    #pragma omp parallel for schedule(static) num_threads(num_bands)
+    for (int band = 0; band < num_bands; ++band) {
+        const std::vector<uint8_t>& stream = delta.bands[band];
+        const uint8_t* in = stream.data();
+        const uint8_t* end = in + stream.size();
+        int y = bandRow(band, num_bands), x = 0;
+        while (in < end) {
+            size_t zeros = getVarint(in);
+            size_t literals = getVarint(in);
+            x += static_cast<int>(zeros % GRID_WIDTH);  // Skip unchanged cells
+            y += static_cast<int>(zeros / GRID_WIDTH);
+            if (x >= GRID_WIDTH) {
+                x -= GRID_WIDTH;
+                ++y;
+            }
+            for (size_t i = 0; i < literals; ++i) {
+                grid[y * PITCH + 1 + x] ^= *in++;
+                if (++x == GRID_WIDTH) {
+                    x = 0;
+                    ++y;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+size_t History::bytes() const {
+    size_t total = 0;
+    for (int i = 0; i < count; ++i) {
+        const Delta& delta = ring[(head + capacity - 1 - i) % capacity];
+        for (const auto& band : delta.bands)
+            total += band.size();
+    }
+    return total;
+}
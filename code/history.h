@@ -0,0 +1,57 @@
+/*
+Description:
+Ring buffer of recent generations used to step the simulation backwards.
+*/
+
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include "life.h"
+#include <vector>
+
+/*
+Each entry is the XOR of a generation with the one before it, run-length
+coded so that the mostly unchanged cells cost almost nothing. Applying the
+newest entry to the current grid restores the previous generation. Entries
+are encoded and decoded in parallel row bands; once the ring is full the
+oldest entry is overwritten and its buffers are reused.
+
+Painted edits are not generations of their own. The grid as it was before
+the first edit since the last generation is kept as the base of the next
+entry, so rewinding that entry restores the unedited generation and every
+earlier generation stays exactly as it was computed.
+*/
+class History {
+public:
+    explicit History(int capacity);
+
+    // Records the change from 'before' (or the grid saved by saveBase) to 'after', the generation that follows it
+    void record(const Grid& before, const Grid& after);
+
+    // Keeps the grid as it is before an edit, once per generation, as the base of the next entry
+    void saveBase(const Grid& grid);
+
+    // Turns the grid back into the previous recorded generation, false if the history is empty
+    bool rewind(Grid& grid);
+
+    void clear() {
+        count = 0;
+        edited = false;
+    }
+    int size() const { return count; }
+    size_t bytes() const;  // Encoded size of all stored entries
+
+private:
+    struct Delta {
+        std::vector<std::vector<uint8_t>> bands;  // One run-length stream per row band
+    };
+
+    int capacity;
+    std::vector<Delta> ring;
+    int head = 0;   // Slot of the next entry to write
+    int count = 0;  // Number of valid entries
+    Grid base;             // Current generation before the edits made since it was computed
+    bool edited = false;   // base holds a grid that record() and rewind() must use
+};
+
+#endif
@@ -0,0 +1,407 @@
+/*
+Description:
+Hybrid backend (-t HYB). A persistent thread pool runs every row-parallel
+stage, one contiguous band of rows per thread. Two-state Life-like rules
+skip the byte kernels: the grid is packed into 64-cell words once per call
+and every generation is computed with bit-sliced full adders on whole
+vectors of words, 256 bits at a time on CPUs with AVX2.
+*/
+
+#include "life.h"
+#include "rules.h"
+#include "topology.h"
+#include "density.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HYBRID_AVX2 1  // Build an AVX2 kernel next to the baseline one and pick at run time
+#endif
+
+// Four and two 64-bit words handled as one value, with the usual bitwise and shift operators
+typedef uint64_t Words4 __attribute__((vector_size(32)));
+typedef uint64_t Words2 __attribute__((vector_size(16)));
+
+/*
+Threads that stay alive between calls. run() hands every thread one part of
+a job and returns when all parts are done. Only one thread may call run()
+at a time. While the pool fits on the physical cores, worker i is pinned to
+core i so that no two workers share a core through SMT; the caller keeps
+its own affinity and the scheduler places it on the free core. Larger pools
+are left to the scheduler.
+*/
+class ThreadPool {
+public:
+    ~ThreadPool() { resize(0); }
+
+    // Runs job(part) for every part in [0, parts), part 0 on the calling thread
+    void run(int parts, const std::function<void(int)>& job) {
+        if (static_cast<int>(workers.size()) != parts - 1)
+            resize(parts - 1);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            current_job = &job;
+            pending = parts - 1;
+            ++epoch;
+        }
+        wake.notify_all();
+        job(0);
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this] { return pending == 0; });
+    }
+
+private:
+    void resize(int count) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers)
+            t.join();
+        workers.clear();
+        stopping = false;
+        bool pin = count < cpuTopology().physical_cores;  // Room for every worker and the caller on its own core
+        for (int i = 0; i < count; ++i)
+            workers.emplace_back(&ThreadPool::work, this, i + 1, epoch, pin);
+    }
+
+    void work(int part, long long seen, bool pin) {
+        if (pin)
+            pinThreadToCore(part);
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || epoch != seen; });
+            if (stopping)
+                return;
+            seen = epoch;
+            const std::function<void(int)>* job = current_job;
+            lock.unlock();
+            (*job)(part);
+            lock.lock();
+            if (--pending == 0)
+                done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers;  // Worker i runs part i + 1
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(int)>* current_job = nullptr;
+    long long epoch = 0;   // Incremented for every job
+    int pending = 0;       // Worker parts of the current job still running
+    bool stopping = false;
+};
+
+static ThreadPool POOL;
+
+/*
+Barrier for the parts of one pool job. The last thread to arrive starts the
+next phase; the others spin briefly and then yield, so oversubscribed runs
+still make progress.
+*/
+class PhaseBarrier {
+public:
+    explicit PhaseBarrier(int count) : count(count) {}
+
+    void wait() {
+        int current = phase.load(std::memory_order_acquire);
+        if (arrived.fetch_add(1, std::memory_order_acq_rel) == count - 1) {
+            arrived.store(0, std::memory_order_relaxed);
+            phase.fetch_add(1, std::memory_order_release);
+            return;
+        }
+        for (int spins = 0; phase.load(std::memory_order_acquire) == current; ++spins) {
+            if (spins > 64)
+                std::this_thread::yield();
+        }
+    }
+
+private:
+    const int count;
+    std::atomic<int> arrived{0};
+    std::atomic<int> phase{0};
+};
+
+/*
+Splits rows [begin, end) into one contiguous band per thread.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- part: Band index.
+- parts: Number of bands.
+
+Returns:
+- The first row of the band; part + 1 gives the row after its last one.
+*/
+static int bandStart(int begin, int end, int part, int parts) {
+    return begin + static_cast<int>(static_cast<long long>(end - begin) * part / parts);
+}
+
+/*
+Runs a row task on the persistent pool, one band of rows per thread.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- task: Work to run on each band of rows.
+
+Returns:
+- void
+*/
+void runRowsPool(int begin, int end, const RowTask& task) {
+    int parts = std::max(1, std::min(NUM_THREADS, end - begin));
+    POOL.run(parts, [&](int part) {
+        int start_row = bandStart(begin, end, part, parts), end_row = bandStart(begin, end, part + 1, parts);
+        auto start = std::chrono::steady_clock::now();
+        if (end_row > start_row)
+            task(start_row, end_row);
+        addBusyTime(part, start);
+    });
+}
+
+static const Backend POOL_BACKEND = {"HYB", runRowsPool, "pool threads", nullptr, nullptr};
+
+// Bit-packed grids: (GRID_HEIGHT + 2) rows of packed_pitch words, bit x % 64 of word 1 + x / 64 is cell x
+static std::vector<uint64_t> packed[2];
+static int packed_pitch = 0;
+
+/*
+Packs rows of the byte grid into words. Eight cells are gathered at a time:
+a multiply moves the low bit of each byte into the top byte of the product.
+*/
+static void packRows(const Grid& grid, uint64_t* words, int y_begin, int y_end) {
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint8_t* cells = &grid[y * PITCH + 1];
+        uint64_t* row = words + static_cast<size_t>(y) * packed_pitch;
+        for (int i = 1; i < packed_pitch - 1; ++i) {
+            int x0 = (i - 1) * 64, count = std::min(64, GRID_WIDTH - x0);
+            uint64_t word = 0;
+            if (count == 64) {
+                for (int k = 0; k < 8; ++k) {
+                    uint64_t eight;
+                    std::memcpy(&eight, cells + x0 + 8 * k, 8);
+                    word |= ((eight & 0x0101010101010101ULL) * 0x0102040810204080ULL) >> 56 << (8 * k);
+                }
+            } else {
+                for (int b = 0; b < count; ++b)
+                    word |= static_cast<uint64_t>(cells[x0 + b] & 1) << b;
+            }
+            row[i] = word;
+        }
+    }
+}
+
+/*
+Unpacks rows of words into the byte grid, eight cells per table lookup.
+*/
+static void unpackRows(const uint64_t* words, Grid& grid, int y_begin, int y_end) {
+    static const std::vector<uint64_t> spread = [] {
+        std::vector<uint64_t> table(256);
+        for (int bits = 0; bits < 256; ++bits) {
+            for (int j = 0; j < 8; ++j)
+                table[bits] |= static_cast<uint64_t>((bits >> j) & 1) << (8 * j);
+        }
+        return table;
+    }();
+    for (int y = y_begin; y < y_end; ++y) {
+        uint8_t* cells = &grid[y * PITCH + 1];
+        const uint64_t* row = words + static_cast<size_t>(y) * packed_pitch;
+        int x = 0;
+        for (; x + 8 <= GRID_WIDTH; x += 8) {
+            uint64_t eight = spread[(row[1 + x / 64] >> (x % 64)) & 0xFF];
+            std::memcpy(cells + x, &eight, 8);
+        }
+        for (; x < GRID_WIDTH; ++x)
+            cells[x] = (row[1 + x / 64] >> (x % 64)) & 1;
+    }
+}
+
+/*
+Computes the next state of the cells in one value of words (one word, or
+two or four side by side) and stores it at out. The left and right neighbors of every cell come
+from loading the row again one word earlier and later and shifting by one
+bit, so no shuffles are needed across the lanes. The eight neighbors are
+added with full adders: the three cells above and the three below give two
+2-bit sums, the left and right cells a third, and adding those gives the
+count as four bit planes. B3/S23 then needs a handful of operations; other
+Life-like rules compare the planes with each count in their birth and
+survival sets.
+*/
+template <class V, bool LIFE>
+static inline __attribute__((always_inline)) void nextWords(const uint64_t* up, const uint64_t* mid, const uint64_t* down, uint64_t* out,
+                                                             unsigned birth, unsigned survive) {
+    V rows[3][3];  // Left neighbor, cell and right neighbor of the rows above, at and below each cell
+    const uint64_t* sources[3] = {up, mid, down};
+    for (int r = 0; r < 3; ++r) {
+        V previous, current, next;
+        std::memcpy(&previous, sources[r] - 1, sizeof(V));
+        std::memcpy(&current, sources[r], sizeof(V));
+        std::memcpy(&next, sources[r] + 1, sizeof(V));
+        rows[r][0] = (current << 1) | (previous >> 63);
+        rows[r][1] = current;
+        rows[r][2] = (current >> 1) | (next << 63);
+    }
+
+    // Full adders over the rows above and below, a half adder over left and right
+    V ones_up = rows[0][0] ^ rows[0][1] ^ rows[0][2];
+    V twos_up = (rows[0][0] & rows[0][1]) | (rows[0][2] & (rows[0][0] ^ rows[0][1]));
+    V ones_down = rows[2][0] ^ rows[2][1] ^ rows[2][2];
+    V twos_down = (rows[2][0] & rows[2][1]) | (rows[2][2] & (rows[2][0] ^ rows[2][1]));
+    V ones_mid = rows[1][0] ^ rows[1][2];
+    V twos_mid = rows[1][0] & rows[1][2];
+
+    // Add the three 2-bit sums into the count planes
+    V bit0 = ones_up ^ ones_down ^ ones_mid;
+    V carry_ones = (ones_up & ones_down) | (ones_mid & (ones_up ^ ones_down));
+    V twos = twos_up ^ twos_down ^ twos_mid;
+    V fours = (twos_up & twos_down) | (twos_mid & (twos_up ^ twos_down));
+    V bit1 = twos ^ carry_ones;
+    V carry_twos = twos & carry_ones;
+    V bit2 = fours ^ carry_twos;
+    V bit3 = fours & carry_twos;
+
+    V alive = rows[1][1], next;
+    if (LIFE) {
+        next = bit1 & ~(bit2 | bit3) & (bit0 | alive);  // Two or three neighbors, and three or alive
+        std::memcpy(out, &next, sizeof(V));
+        return;
+    }
+
+    V born = alive ^ alive, kept = alive ^ alive;
+    const V planes[4] = {bit0, bit1, bit2, bit3};
+    for (int n = 0; n <= 8; ++n) {
+        if (!((birth | survive) >> n & 1))
+            continue;
+        V equal = ~(alive ^ alive);
+        for (int j = 0; j < 4; ++j)
+            equal &= ((n >> j) & 1) ? planes[j] : ~planes[j];
+        if (birth >> n & 1)
+            born |= equal;
+        if (survive >> n & 1)
+            kept |= equal;
+    }
+    next = (alive & kept) | (~alive & born);
+    std::memcpy(out, &next, sizeof(V));
+}
+
+/*
+Computes rows of the packed grid with values of V, then the words left over
+one at a time. Bits past the last cell are cleared so they never count as
+live neighbors.
+*/
+template <class V, bool LIFE>
+static inline __attribute__((always_inline)) void stepRowsWith(const uint64_t* words_current, uint64_t* words_next, int y_begin,
+                                                                int y_end, unsigned birth, unsigned survive) {
+    const int words = packed_pitch - 2, lanes = sizeof(V) / sizeof(uint64_t);
+    const uint64_t last_mask = (GRID_WIDTH % 64) ? ~0ULL >> (64 - GRID_WIDTH % 64) : ~0ULL;
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint64_t* mid = words_current + static_cast<size_t>(y) * packed_pitch;
+        const uint64_t* up = mid - packed_pitch;
+        const uint64_t* down = mid + packed_pitch;
+        uint64_t* out = words_next + static_cast<size_t>(y) * packed_pitch;
+        int i = 1;
+        for (; i + lanes - 1 <= words; i += lanes)
+            nextWords<V, LIFE>(up + i, mid + i, down + i, out + i, birth, survive);
+        for (; i <= words; ++i)
+            nextWords<uint64_t, LIFE>(up + i, mid + i, down + i, out + i, birth, survive);
+        out[words] &= last_mask;
+    }
+}
+
+template <bool LIFE>
+static void stepRowsBaseline(const uint64_t* words_current, uint64_t* words_next, int y_begin, int y_end, unsigned birth, unsigned survive) {
+    stepRowsWith<Words2, LIFE>(words_current, words_next, y_begin, y_end, birth, survive);
+}
+
+#ifdef HYBRID_AVX2
+template <bool LIFE>
+__attribute__((target("avx2"))) static void stepRowsAVX2(const uint64_t* words_current, uint64_t* words_next, int y_begin, int y_end,
+                                                         unsigned birth, unsigned survive) {
+    stepRowsWith<Words4, LIFE>(words_current, words_next, y_begin, y_end, birth, survive);
+}
+#endif
+
+typedef void (*PackedKernel)(const uint64_t* words_current, uint64_t* words_next, int y_begin, int y_end, unsigned birth, unsigned survive);
+
+/*
+Picks the kernel for the active rule and the CPU: the B3/S23 or the general
+Life-like logic, on 256-bit vectors when the CPU has AVX2 and on 128-bit
+ones otherwise.
+*/
+static PackedKernel selectKernel(bool life) {
+#ifdef HYBRID_AVX2
+    static const bool avx2 = (__builtin_cpu_init(), __builtin_cpu_supports("avx2"));
+    if (avx2)
+        return life ? stepRowsAVX2<true> : stepRowsAVX2<false>;
+#endif
+    return life ? stepRowsBaseline<true> : stepRowsBaseline<false>;
+}
+
+/*
+Computes several generations with the hybrid backend. For two-state
+Life-like rules every pool thread owns one band of rows for the whole call:
+it packs its rows, computes them generation after generation in the packed
+grids (waiting at a barrier for its neighbors after each one, since the
+next generation reads their edge rows) and unpacks its rows of the last
+generation into grid_next, so each band stays in its thread's cache. Other
+rules step one generation at a time with their byte kernels on the pool.
+
+Parameters:
+- grid_current: Reference to the grid to start from.
+- grid_next: Reference to the grid where the last generation will be stored.
+- generations: Number of generations to compute, at least one.
+
+Returns:
+- void
+*/
+void runGenerationsHybrid(Grid& grid_current, Grid& grid_next, int generations) {
+    if (!isLifeLikeRule(RULE)) {
+        for (int g = 0; g < generations; ++g) {
+            if (g > 0)
+                std::swap(grid_current, grid_next);
+            RULE.update(&POOL_BACKEND, grid_current, grid_next);
+        }
+        return;
+    }
+
+    int pitch = (GRID_WIDTH + 63) / 64 + 2;
+    size_t words = static_cast<size_t>(GRID_HEIGHT + 2) * pitch;
+    if (pitch != packed_pitch || packed[0].size() != words) {
+        packed_pitch = pitch;
+        for (auto& grid : packed)
+            grid.assign(words, 0);  // Padding words and rows stay zero from here on
+    }
+
+    unsigned birth = 0, survive = 0;
+    for (int n = 0; n <= 8; ++n) {
+        birth |= static_cast<unsigned>(RULE.birth[n] != 0) << n;
+        survive |= static_cast<unsigned>(RULE.survive[n] != 0) << n;
+    }
+    const PackedKernel kernel = selectKernel(birth == 0x008 && survive == 0x00C);  // B3/S23
+
+    int parts = std::max(1, std::min(NUM_THREADS, GRID_HEIGHT));
+    PhaseBarrier barrier(parts);
+    POOL.run(parts, [&](int part) {
+        int y_begin = bandStart(1, GRID_HEIGHT + 1, part, parts), y_end = bandStart(1, GRID_HEIGHT + 1, part + 1, parts);
+        auto start = std::chrono::steady_clock::now();
+        packRows(grid_current, packed[0].data(), y_begin, y_end);
+        addBusyTime(part, start);
+        for (int g = 0; g < generations; ++g) {
+            barrier.wait();
+            start = std::chrono::steady_clock::now();
+            kernel(packed[g % 2].data(), packed[1 - g % 2].data(), y_begin, y_end, birth, survive);
+            addBusyTime(part, start);
+        }
+        start = std::chrono::steady_clock::now();
+        unpackRows(packed[generations % 2].data(), grid_next, y_begin, y_end);
+        reportChangedCells(grid_current, grid_next, y_begin, y_end);  // grid_current still holds the first generation
+        addBusyTime(part, start);
+    });
+}
@@ -0,0 +1,406 @@
+/*
+Description:
+Lenia kernel, growth function and the two convolution paths: direct
+convolution for small radii and a radix-2 FFT for large ones.
+*/
+
+#include "lenia.h"
+#include "rules.h"
+#include "density.h"
+#include <cctype>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <sstream>
+
+typedef std::complex<float> Complex;
+
+// Radix-2 transform of one length, shared by every row or column of that length
+struct FFTPlan {
+    int size = 0;
+    std::vector<int> reversed;      // Bit-reversed position of every index
+    std::vector<Complex> twiddles;  // exp(-2 pi i k / size) for k < size / 2
+};
+
+// Convolution state, rebuilt whenever the grid size or kernel radius changes
+int LENIA_DIRECT_RANGE = 4;
+
+static int cached_width = -1, cached_height = -1, cached_range = -1;
+static bool cached_direct = false;
+static int fft_width = 0, fft_height = 0;    // Power of two sizes with room for the kernel to wrap onto zeros
+static FFTPlan row_plan, column_plan;
+static std::vector<Complex> spectrum;        // fft_height rows of the fft_width / 2 + 1 non-redundant frequencies
+static std::vector<Complex> kernel_spectrum; // Kernel transform scaled for the inverse, same columns, column-major
+static std::vector<float> padded;            // Direct path: levels with R dead cells on every side
+static std::vector<int> tap_offsets;         // Direct path: offset of each kernel cell in padded
+static std::vector<float> tap_weights;       // Direct path: weight of each kernel cell
+
+/*
+Weight of a kernel cell at distance r (in units of the radius R): a smooth
+bump that peaks halfway out and vanishes at the center and at R.
+*/
+static double kernelShell(double r) {
+    if (r <= 0 || r >= 1)
+        return 0;
+    return std::exp(4 - 1 / (r * (1 - r)));
+}
+
+/*
+Growth of a cell whose weighted neighborhood sum is u: +1 at the growth
+center, falling to -1 within a few widths of it.
+*/
+static float growth(float u, float center, float width) {
+    float d = (u - center) / width;
+    return 2 * std::exp(-0.5f * d * d) - 1;
+}
+
+static Complex multiply(Complex a, Complex b) {
+    return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+static void makePlan(FFTPlan& plan, int size) {
+    if (plan.size == size)
+        return;
+    plan.size = size;
+    int bits = 0;
+    while ((1 << bits) < size)
+        ++bits;
+    plan.reversed.resize(size);
+    for (int i = 0; i < size; ++i) {
+        int r = 0;
+        for (int b = 0; b < bits; ++b)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        plan.reversed[i] = r;
+    }
+    plan.twiddles.resize(size / 2);
+    for (int k = 0; k < size / 2; ++k) {
+        double angle = -2 * std::acos(-1.0) * k / size;
+        plan.twiddles[k] = Complex(static_cast<float>(std::cos(angle)), static_cast<float>(std::sin(angle)));
+    }
+}
+
+/*
+Transforms one row or column in place with the iterative radix-2
+Cooley-Tukey algorithm. The inverse is unscaled.
+
+Parameters:
+- plan: Plan for the length of the data.
+- data: Values to transform.
+- inverse: true for the inverse transform.
+
+Returns:
+- void
+*/
+static void transform(const FFTPlan& plan, Complex* data, bool inverse) {
+    int n = plan.size;
+    for (int i = 0; i < n; ++i) {
+        int j = plan.reversed[i];
+        if (i < j)
+            std::swap(data[i], data[j]);
+    }
+    for (int half = 1; half < n; half <<= 1) {
+        int step = n / (2 * half);  // Twiddle stride for butterflies of this span
+        for (int start = 0; start < n; start += 2 * half) {
+            for (int k = 0; k < half; ++k) {
+                Complex w = plan.twiddles[k * step];
+                if (inverse)
+                    w = std::conj(w);
+                Complex a = data[start + k], b = multiply(data[start + k + half], w);
+                data[start + k] = a + b;
+                data[start + k + half] = a - b;
+            }
+        }
+    }
+}
+
+/*
+Rebuilds the kernel and the convolution buffers for the current grid size
+and kernel radius. The kernel is normalized so a neighborhood full of level
+1 sums to 1.
+*/
+static void prepareKernel() {
+    const int range = RULE.range;
+    const bool direct = range <= LENIA_DIRECT_RANGE;
+    if (cached_width == GRID_WIDTH && cached_height == GRID_HEIGHT && cached_range == range && cached_direct == direct)
+        return;
+    cached_width = GRID_WIDTH;
+    cached_height = GRID_HEIGHT;
+    cached_range = range;
+    cached_direct = direct;
+
+    std::vector<double> weights((2 * range + 1) * (2 * range + 1));
+    double total = 0;
+    for (int dy = -range; dy <= range; ++dy) {
+        for (int dx = -range; dx <= range; ++dx) {
+            double w = kernelShell(std::sqrt(static_cast<double>(dx * dx + dy * dy)) / range);
+            weights[(dy + range) * (2 * range + 1) + dx + range] = w;
+            total += w;
+        }
+    }
+
+    if (direct) {
+        int padded_width = GRID_WIDTH + 2 * range;
+        padded.assign(static_cast<size_t>(padded_width) * (GRID_HEIGHT + 2 * range), 0);
+        tap_offsets.clear();
+        tap_weights.clear();
+        for (int dy = -range; dy <= range; ++dy) {
+            for (int dx = -range; dx <= range; ++dx) {
+                double w = weights[(dy + range) * (2 * range + 1) + dx + range];
+                if (w > 0) {
+                    tap_offsets.push_back(dy * padded_width + dx);
+                    tap_weights.push_back(static_cast<float>(w / total));
+                }
+            }
+        }
+        return;
+    }
+
+    // Cells past the last row and column stay dead, so the circular
+    // convolution only wraps onto zeros when there are at least R of them
+    fft_width = 1;
+    while (fft_width < GRID_WIDTH + range)
+        fft_width <<= 1;
+    fft_height = 1;
+    while (fft_height < GRID_HEIGHT + range)
+        fft_height <<= 1;
+    makePlan(row_plan, fft_width);
+    makePlan(column_plan, fft_height);
+    const int half = fft_width / 2 + 1;
+    spectrum.assign(static_cast<size_t>(half) * fft_height, 0);  // Rows past the grid stay zero
+
+    std::vector<Complex> kernel(static_cast<size_t>(fft_width) * fft_height, 0);
+    float scale = static_cast<float>(1.0 / (total * fft_width * fft_height));
+    for (int dy = -range; dy <= range; ++dy) {
+        for (int dx = -range; dx <= range; ++dx) {
+            int y = (dy + fft_height) % fft_height, x = (dx + fft_width) % fft_width;
+            kernel[static_cast<size_t>(y) * fft_width + x] = static_cast<float>(weights[(dy + range) * (2 * range + 1) + dx + range]) * scale;
+        }
+    }
+    for (int y = 0; y < fft_height; ++y)
+        transform(row_plan, &kernel[static_cast<size_t>(y) * fft_width], false);
+    kernel_spectrum.resize(static_cast<size_t>(half) * fft_height);
+    std::vector<Complex> column(fft_height);
+    for (int x = 0; x < half; ++x) {
+        for (int y = 0; y < fft_height; ++y)
+            column[y] = kernel[static_cast<size_t>(y) * fft_width + x];
+        transform(column_plan, column.data(), false);
+        std::copy(column.begin(), column.end(), kernel_spectrum.begin() + static_cast<size_t>(x) * fft_height);
+    }
+}
+
+/*
+Moves a row one time step along the growth function, given the
+weighted neighborhood sum of every cell.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y: Padded row to compute.
+- sums: Neighborhood sum of each cell of the row.
+
+Returns:
+- void
+*/
+static void growRow(const Grid& grid_current, Grid& grid_next, int y, const float* sums) {
+    const float center = static_cast<float>(RULE.growth_center), width = static_cast<float>(RULE.growth_width);
+    const float dt = 1.0f / RULE.time_steps;
+    const uint8_t* in = &grid_current[y * PITCH + 1];
+    uint8_t* out = &grid_next[y * PITCH + 1];
+    #pragma omp simd
+    for (int x = 0; x < GRID_WIDTH; ++x) {
+        float level = in[x] / 255.0f + dt * growth(sums[x], center, width);
+        level = std::min(1.0f, std::max(0.0f, level));
+        out[x] = static_cast<uint8_t>(level * 255 + 0.5f);
+    }
+}
+
+/*
+Computes one Lenia generation. Both convolution paths run as row-parallel
+stages on the backend.
+- Direct (R <= LENIA_DIRECT_RANGE): the levels are copied into a padded
+  float field, then every cell sums its kernel taps.
+- FFT: rows are real, so each pair of rows is transformed at once as the
+  real and imaginary parts of one complex row and the two spectra are
+  separated by their conjugate symmetry. Only the fft_width / 2 + 1
+  frequencies that are not mirror images of others go through the column
+  transforms, the product with the kernel spectrum and the inverse column
+  transforms, which split across threads like rows. The inverse row
+  transform packs pairs of rows again and grows both.
+
+Parameters:
+- backend: Backend that runs the row-parallel stages.
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+
+Returns:
+- void
+*/
+void updateLenia(const Backend* backend, Grid& grid_current, Grid& grid_next) {
+    prepareKernel();
+    const int range = RULE.range;
+
+    if (range <= LENIA_DIRECT_RANGE) {
+        const int padded_width = GRID_WIDTH + 2 * range;
+        backend->run_rows(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) {
+            for (int y = y_begin; y < y_end; ++y) {
+                const uint8_t* in = &grid_current[y * PITCH + 1];
+                float* row = &padded[static_cast<size_t>(y - 1 + range) * padded_width + range];
+                #pragma omp simd
+                for (int x = 0; x < GRID_WIDTH; ++x)
+                    row[x] = in[x] / 255.0f;
+            }
+        });
+        backend->run_rows(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) {
+            std::vector<float> sums(GRID_WIDTH);
+            const int taps = static_cast<int>(tap_offsets.size());
+            for (int y = y_begin; y < y_end; ++y) {
+                const float* row = &padded[static_cast<size_t>(y - 1 + range) * padded_width + range];
+                #pragma omp simd
+                for (int x = 0; x < GRID_WIDTH; ++x) {
+                    float sum = 0;
+                    for (int t = 0; t < taps; ++t)
+                        sum += tap_weights[t] * row[x + tap_offsets[t]];
+                    sums[x] = sum;
+                }
+                growRow(grid_current, grid_next, y, sums.data());
+            }
+            reportChangedCells(grid_current, grid_next, y_begin, y_end);
+        });
+        return;
+    }
+
+    const int half = fft_width / 2 + 1;
+    const int pairs = (GRID_HEIGHT + 1) / 2;
+
+    // Forward transform of each pair of grid rows
+    backend->run_rows(0, pairs, [&](int p_begin, int p_end) {
+        std::vector<Complex> packed(fft_width);
+        for (int p = p_begin; p < p_end; ++p) {
+            int y = 2 * p;
+            bool second = y + 1 < GRID_HEIGHT;
+            const uint8_t* a = &grid_current[(y + 1) * PITCH + 1];
+            const uint8_t* b = a + PITCH;
+            std::fill(packed.begin(), packed.end(), Complex(0));
+            #pragma omp simd
+            for (int x = 0; x < GRID_WIDTH; ++x)
+                packed[x] = Complex(a[x] / 255.0f, second ? b[x] / 255.0f : 0);
+            transform(row_plan, packed.data(), false);
+
+            Complex* out_a = &spectrum[static_cast<size_t>(y) * half];
+            Complex* out_b = out_a + half;
+            for (int k = 0; k < half; ++k) {
+                Complex z = packed[k], mirror = std::conj(packed[(fft_width - k) % fft_width]);
+                out_a[k] = 0.5f * (z + mirror);
+                if (second)
+                    out_b[k] = Complex(0, -0.5f) * (z - mirror);
+            }
+        }
+    });
+
+    // Column transforms and the product with the kernel
+    backend->run_rows(0, half, [&](int k_begin, int k_end) {
+        std::vector<Complex> column(fft_height);
+        for (int k = k_begin; k < k_end; ++k) {
+            const Complex* kernel = &kernel_spectrum[static_cast<size_t>(k) * fft_height];
+            for (int y = 0; y < fft_height; ++y)
+                column[y] = spectrum[static_cast<size_t>(y) * half + k];
+            transform(column_plan, column.data(), false);
+            for (int y = 0; y < fft_height; ++y)
+                column[y] = multiply(column[y], kernel[y]);
+            transform(column_plan, column.data(), true);
+            for (int y = 0; y < GRID_HEIGHT; ++y)  // Only the grid rows are transformed back
+                spectrum[static_cast<size_t>(y) * half + k] = column[y];
+        }
+    });
+
+    // Inverse transform of each pair of grid rows and the growth step
+    backend->run_rows(0, pairs, [&](int p_begin, int p_end) {
+        std::vector<Complex> packed(fft_width);
+        std::vector<float> sums_a(GRID_WIDTH), sums_b(GRID_WIDTH);
+        for (int p = p_begin; p < p_end; ++p) {
+            int y = 2 * p;
+            bool second = y + 1 < GRID_HEIGHT;
+            const Complex* in_a = &spectrum[static_cast<size_t>(y) * half];
+            const Complex* in_b = in_a + half;
+            for (int k = 0; k < fft_width; ++k) {
+                Complex a = (k < half) ? in_a[k] : std::conj(in_a[fft_width - k]);
+                Complex b = !second ? Complex(0) : (k < half) ? in_b[k] : std::conj(in_b[fft_width - k]);
+                packed[k] = a + Complex(-b.imag(), b.real());  // a + i b
+            }
+            transform(row_plan, packed.data(), true);
+            #pragma omp simd
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                sums_a[x] = packed[x].real();
+                sums_b[x] = packed[x].imag();
+            }
+            growRow(grid_current, grid_next, y + 1, sums_a.data());
+            if (second)
+                growRow(grid_current, grid_next, y + 2, sums_b.data());
+            reportChangedCells(grid_current, grid_next, y + 1, second ? y + 3 : y + 2);
+        }
+    });
+}
+
+/*
+Parses a Lenia rule: LENIA alone for the defaults (the Orbium parameters)
+or followed by any of R (kernel radius), T (generations per unit time), M
+(growth center) and S (growth width), as in LENIA,R13,T10,M0.15,S0.015.
+
+Parameters:
+- spec: Rule string.
+- rule: Rule to fill in.
+
+Returns:
+- true if the string was a valid Lenia rule.
+*/
+bool parseLenia(const std::string& spec, Rule& rule) {
+    std::vector<std::string> fields(1);
+    for (char c : spec) {
+        if (c == ',')
+            fields.push_back("");
+        else
+            fields.back() += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+    if (fields[0] != "LENIA")
+        return false;
+
+    Rule parsed;
+    parsed.continuous = true;
+    parsed.states = 256;
+    parsed.range = 13;
+    for (size_t i = 1; i < fields.size(); ++i) {
+        if (fields[i].size() < 2)
+            return false;
+        char* end = nullptr;
+        double value = std::strtod(fields[i].c_str() + 1, &end);
+        if (*end != '\0' || !(value > 0))
+            return false;
+        switch (fields[i][0]) {
+            case 'R':
+                if (value != std::floor(value) || value > MAX_RANGE)
+                    return false;
+                parsed.range = static_cast<int>(value);
+                break;
+            case 'T':
+                if (value != std::floor(value) || value > 1000)
+                    return false;
+                parsed.time_steps = static_cast<int>(value);
+                break;
+            case 'M':
+                parsed.growth_center = value;
+                break;
+            case 'S':
+                parsed.growth_width = value;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    std::ostringstream name;
+    name << "LENIA,R" << parsed.range << ",T" << parsed.time_steps << ",M" << parsed.growth_center << ",S" << parsed.growth_width;
+    parsed.name = name.str();
+    parsed.update = updateLenia;
+    rule = parsed;
+    return true;
+}
@@ -0,0 +1,24 @@
+/*
+Description:
+Lenia, a continuous cellular automaton. Cells hold a level between 0 and 1
+stored in 8 bits, the neighborhood is a smooth ring weighted by a kernel of
+radius R and every generation moves each cell a small step along a growth
+function of its weighted neighborhood sum.
+*/
+
+#ifndef LENIA_H
+#define LENIA_H
+
+#include "life.h"
+#include <string>
+
+struct Rule;
+
+// Largest kernel radius computed by direct convolution, larger ones use the FFT (raised by -v to check the FFT)
+extern int LENIA_DIRECT_RANGE;
+
+// Function Prototypes
+bool parseLenia(const std::string& spec, Rule& rule);
+void updateLenia(const Backend* backend, Grid& grid_current, Grid& grid_next);
+
+#endif
@@ -0,0 +1,563 @@
+/*
+Description:
+Grid seeding, hashing, the default Game of Life kernel and the backends
+that run rule kernels across threads.
+*/
+
+#include "life.h"
+#include "rules.h"
+#include "volume.h"
+#include <omp.h>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#ifdef LAB2_PSTL
+#include <execution>
+#include <numeric>
+#endif
+#if defined(LAB2_TBB) || defined(LAB2_PSTL_TBB)
+#include <tbb/global_control.h>
+#include <tbb/task_arena.h>
+#endif
+#ifdef LAB2_TBB
+#include <tbb/blocked_range.h>
+#include <tbb/blocked_range2d.h>
+#include <tbb/parallel_for.h>
+#endif
+
+// Grid size variables calculated from the window dimensions and pixel size in main
+int GRID_WIDTH = 800 / 5;
+int GRID_HEIGHT = 600 / 5;
+int PITCH = GRID_WIDTH + 2;  // Padding to eliminate boundary checks
+int NUM_THREADS = 1;  // One per physical core unless -n is given, set in main
+
+// Registered backends, selected by name with -t
+const Backend BACKENDS[] = {
+    {"SEQ", runRowsSequential, nullptr, nullptr, nullptr},
+    {"THRD", runRowsThread, "std::threads", nullptr, nullptr},
+    {"OMP", runRowsOMP, "OMP threads", nullptr, nullptr},
+    {"OMPT", runRowsOMPTasks, "OMP task threads", runGenerationsOMPTasks, nullptr},
+#ifdef LAB2_PSTL
+    {"PSTL", runRowsPSTL, "parallel STL threads", nullptr, nullptr},
+#endif
+#ifdef LAB2_TBB
+    {"TBB", runRowsTBB, "TBB threads", nullptr, runTilesTBB},
+#endif
+    {"HYB", runRowsPool, "pool threads", runGenerationsHybrid, nullptr},
+};
+const int NUM_BACKENDS = sizeof(BACKENDS) / sizeof(BACKENDS[0]);
+
+std::atomic<long long> THREAD_BUSY_NS[MAX_TIMED_THREADS];
+
+/*
+Adds the time since start to the busy time of the given thread. Each index
+is only written by its own thread.
+*/
+void addBusyTime(int thread, std::chrono::steady_clock::time_point start) {
+    long long elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    if (thread >= 0 && thread < MAX_TIMED_THREADS)
+        THREAD_BUSY_NS[thread].fetch_add(elapsed, std::memory_order_relaxed);
+}
+
+/*
+Runs one part of a row task and adds its duration to the busy time of the
+thread that ran it.
+*/
+static void runTimed(int thread, const RowTask& task, int begin, int end) {
+    auto start = std::chrono::steady_clock::now();
+    task(begin, end);
+    addBusyTime(thread, start);
+}
+
+/*
+Sets the grid dimensions and recalculates the padded row pitch.
+
+Parameters:
+- width: Number of cells per row.
+- height: Number of rows.
+
+Returns:
+- void
+*/
+void setGridSize(int width, int height) {
+    GRID_WIDTH = width;
+    GRID_HEIGHT = height;
+    PITCH = GRID_WIDTH + 2;  // Update pitch with padding
+}
+
+/*
+Advances a splitmix64 state and returns the next pseudo-random value.
+*/
+uint64_t splitmix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/*
+Seeds the interior of the grid with random cells.
+Each row draws from its own stream derived from the seed, so the same seed
+always produces the same grid regardless of how the rows are split among the
+threads that seed them in parallel. Continuous rules get random levels in
+scattered square patches twice the kernel radius wide instead, which gives
+Lenia patterns room to form between them. 3D rules seed the volume and show
+its current slice.
+
+Parameters:
+- grid: Reference to the grid to fill.
+- seed: Seed for the random number generator.
+
+Returns:
+- void
+*/
+void seedRandomGrid(Grid& grid, uint64_t seed) {
+    if (RULE.volume) {
+        seedVolume(seed);
+        readVolumeSlice(VOLUME_SLICE, grid);
+        return;
+    }
+
+    #pragma omp parallel for schedule(static) num_threads(NUM_THREADS)
+    for (int y = 1; y <= GRID_HEIGHT; ++y) {  // Loop over rows
+        uint64_t state = seed ^ (static_cast<uint64_t>(y) * 0xD1B54A32D192ED03ULL);
+        uint64_t bits = 0;
+        if (RULE.continuous) {
+            int patch = 2 * RULE.range;
+            for (int x = 1; x <= GRID_WIDTH; ++x) {  // Loop over columns
+                uint64_t patch_state = seed ^ (static_cast<uint64_t>((y - 1) / patch) << 32 | static_cast<uint64_t>((x - 1) / patch));
+                bool active = (splitmix64(patch_state) & 3) == 0;  // One patch in four
+                if ((x - 1) % 8 == 0)
+                    bits = splitmix64(state);  // Refill eight random levels
+                grid[y * PITCH + x] = active ? static_cast<uint8_t>(bits) : 0;
+                bits >>= 8;
+            }
+            continue;
+        }
+        for (int x = 1; x <= GRID_WIDTH; ++x) {  // Loop over columns
+            if ((x - 1) % 64 == 0)
+                bits = splitmix64(state);  // Refill 64 random bits
+            grid[y * PITCH + x] = bits & 1;  // Randomly set cell to 0 or 1
+            bits >>= 1;
+        }
+    }
+}
+
+/*
+Computes a 64-bit FNV-1a hash of the interior cells of the grid.
+Padding cells are excluded so grids from different backends compare equal
+whenever their visible state matches.
+
+Parameters:
+- grid: Reference to the grid to hash.
+
+Returns:
+- The hash value.
+*/
+uint64_t hashGrid(const Grid& grid) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int y = 1; y <= GRID_HEIGHT; ++y) {
+        const uint8_t* row = &grid[y * PITCH + 1];
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            hash ^= row[x];
+            hash *= 0x100000001B3ULL;
+        }
+    }
+    return hash;
+}
+
+/*
+Looks up a backend in the registry by its processing type name.
+
+Parameters:
+- name: Processing type (e.g. SEQ, THRD, OMP).
+
+Returns:
+- Pointer to the registry entry, or nullptr if no backend has that name.
+*/
+const Backend* findBackend(const std::string& name) {
+    for (int i = 0; i < NUM_BACKENDS; ++i) {
+        if (name == BACKENDS[i].name)
+            return &BACKENDS[i];
+    }
+    return nullptr;
+}
+
+/*
+Computes one generation with the active rule (-r), using the backend's
+threading for every parallel stage. Backends with their own way of
+computing generations run a single one.
+
+Parameters:
+- backend: Backend that runs the row-parallel stages.
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+
+Returns:
+- void
+*/
+void updateGrid(const Backend* backend, Grid& grid_current, Grid& grid_next) {
+    if (backend->run_generations)
+        backend->run_generations(grid_current, grid_next, 1);
+    else
+        RULE.update(backend, grid_current, grid_next);
+}
+
+/*
+Computes several generations with the active rule. Backends that can
+overlap generations get them all in one call; the others step one
+generation at a time. Both grids are overwritten.
+
+Parameters:
+- backend: Backend that computes the generations.
+- grid_current: Reference to the grid to start from.
+- grid_next: Reference to the grid where the last generation will be stored.
+- generations: Number of generations to compute, at least one.
+
+Returns:
+- void
+*/
+void advanceGrid(const Backend* backend, Grid& grid_current, Grid& grid_next, int generations) {
+    if (backend->run_generations) {
+        backend->run_generations(grid_current, grid_next, generations);
+        return;
+    }
+    for (int g = 0; g < generations; ++g) {
+        if (g > 0)
+            std::swap(grid_current, grid_next);
+        updateGrid(backend, grid_current, grid_next);
+    }
+}
+
+/*
+Applies the standard Game of Life rules (B3/S23) to a range of rows.
+This is the default rule kernel and the fastest path for two-state grids.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y_begin: First padded row to compute.
+- y_end: Padded row after the last one to compute.
+
+Returns:
+- void
+*/
+void updateRowsLife(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end) {
+    updateTileLife(grid_current, grid_next, y_begin, y_end, 1, GRID_WIDTH + 1);
+}
+
+/*
+Applies the standard Game of Life rules (B3/S23) to part of a range of
+rows. Cells only depend on the current grid, so any rectangle can be
+computed on its own. The column loop is marked omp simd: cells are byte
+stores that could alias the grid width as far as the compiler knows, so
+without the annotation it keeps the loop scalar.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y_begin: First padded row to compute.
+- y_end: Padded row after the last one to compute.
+- x_begin: First padded column to compute.
+- x_end: Padded column after the last one to compute.
+
+Returns:
+- void
+*/
+void updateTileLife(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end, int x_begin, int x_end) {
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint8_t* up = &grid_current[(y - 1) * PITCH];
+        const uint8_t* mid = up + PITCH;
+        const uint8_t* down = mid + PITCH;
+        uint8_t* out = &grid_next[y * PITCH];
+        #pragma omp simd
+        for (int x = x_begin; x < x_end; ++x) {
+            // Count the number of alive neighbors
+            int neighbors = up[x - 1] + up[x] + up[x + 1]
+                          + mid[x - 1] + mid[x + 1]
+                          + down[x - 1] + down[x] + down[x + 1];
+            // Apply the Game of Life rules
+            out[x] = (mid[x]) ? (neighbors == 2 || neighbors == 3) : (neighbors == 3);
+        }
+    }
+}
+
+/*
+Runs a row task with sequential processing: the whole range in one call on
+the calling thread.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- task: Work to run on the rows.
+
+Returns:
+- void
+*/
+void runRowsSequential(int begin, int end, const RowTask& task) {
+    runTimed(0, task, begin, end);
+}
+
+/*
+Runs a row task using multiple threads.
+Divides the work among threads by splitting the rows into chunks.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- task: Work to run on each chunk of rows.
+
+Returns:
+- void
+*/
+void runRowsThread(int begin, int end, const RowTask& task) {
+    int total_rows = end - begin;                       // Total number of rows
+    int rows_per_thread = total_rows / NUM_THREADS;     // Rows per thread
+    int extra_rows = total_rows % NUM_THREADS;          // Extra rows to distribute
+
+    std::vector<std::thread> threads;  // Vector to hold threads
+
+    int start_row = begin;  // Starting row for each thread
+    for (int i = 0; i < NUM_THREADS; ++i) {
+        // Calculate end row for this thread
+        int end_row = start_row + rows_per_thread + (i < extra_rows ? 1 : 0);
+        // Create and start the thread
+        if (end_row > start_row)
+            threads.emplace_back(runTimed, i, std::cref(task), start_row, end_row);
+        start_row = end_row;  // Update start row for next thread
+    }
+
+    // Wait for all threads to finish
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+/*
+Runs a row task using OpenMP for parallel processing.
+Each thread of the parallel region takes one contiguous chunk of rows, the
+same split schedule(static) would produce.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- task: Work to run on each chunk of rows.
+
+Returns:
+- void
+*/
+void runRowsOMP(int begin, int end, const RowTask& task) {
+    #pragma omp parallel num_threads(NUM_THREADS)
+    {
+        int thread = omp_get_thread_num(), threads = omp_get_num_threads();
+        int start_row = begin + static_cast<int>(static_cast<long long>(end - begin) * thread / threads);
+        int end_row = begin + static_cast<int>(static_cast<long long>(end - begin) * (thread + 1) / threads);
+        if (end_row > start_row)
+            runTimed(thread, task, start_row, end_row);
+    }
+}
+
+// Row bands per thread for the task backend, a few so threads that finish early can take over
+static const int TASK_BANDS_PER_THREAD = 4;
+
+/*
+Splits rows [begin, end) into bands for the task backend.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- band: Band index.
+- bands: Number of bands.
+
+Returns:
+- The first row of the band; band + 1 gives the row after its last one.
+*/
+static int bandStart(int begin, int end, int band, int bands) {
+    return begin + static_cast<int>(static_cast<long long>(end - begin) * band / bands);
+}
+
+/*
+Runs a row task with OpenMP tasks: one thread of the parallel region creates
+a task per band of rows and the team runs them as they come.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- task: Work to run on each band of rows.
+
+Returns:
+- void
+*/
+void runRowsOMPTasks(int begin, int end, const RowTask& task) {
+    int bands = std::min(end - begin, NUM_THREADS * TASK_BANDS_PER_THREAD);
+    #pragma omp parallel num_threads(NUM_THREADS)
+    #pragma omp single
+    for (int band = 0; band < bands; ++band) {
+        int start_row = bandStart(begin, end, band, bands), end_row = bandStart(begin, end, band + 1, bands);
+        #pragma omp task firstprivate(start_row, end_row)
+        runTimed(omp_get_thread_num(), task, start_row, end_row);
+    }
+}
+
+// Rows the tile backend hands to the rule kernel, set by the task about to call it
+static thread_local int tile_begin, tile_end;
+
+/*
+Runs a row task on the current tile's rows only, whatever range the rule
+kernel asks for. Lets a single-stage rule kernel compute one band.
+*/
+static void runRowsTile(int, int, const RowTask& task) {
+    runTimed(omp_get_thread_num(), task, tile_begin, tile_end);
+}
+
+static const Backend TILE_BACKEND = {"OMPT tile", runRowsTile, "OMP task threads", nullptr, nullptr};
+
+/*
+Computes several generations with one OpenMP task per band of rows and
+generation, without a barrier between generations. Band i of generation
+g + 1 depends on bands i - 1, i and i + 1 of generation g, the rows its
+kernel reads, so it starts as soon as those are done while other bands are
+still working on earlier generations. The grids alternate as source and
+destination; writing a band also waits, through the same dependencies,
+until the tasks reading the previous contents are finished. Rules whose
+kernels have more than one stage or read further than one row away step
+through runRowsOMPTasks one generation at a time.
+
+Parameters:
+- grid_current: Reference to the grid to start from.
+- grid_next: Reference to the grid where the last generation will be stored.
+- generations: Number of generations to compute, at least one.
+
+Returns:
+- void
+*/
+void runGenerationsOMPTasks(Grid& grid_current, Grid& grid_next, int generations) {
+    if (!isRowLocalRule(RULE)) {
+        for (int g = 0; g < generations; ++g) {
+            if (g > 0)
+                std::swap(grid_current, grid_next);
+            RULE.update(findBackend("OMPT"), grid_current, grid_next);
+        }
+        return;
+    }
+
+    int bands = std::min(GRID_HEIGHT, NUM_THREADS * TASK_BANDS_PER_THREAD);
+    Grid* grids[2] = {&grid_current, &grid_next};
+    std::vector<char> tiles(2 * bands);  // Dependency objects of each band of each grid
+
+    #pragma omp parallel num_threads(NUM_THREADS)
+    #pragma omp single
+    for (int g = 0; g < generations; ++g) {
+        int src = g % 2, dst = 1 - src;
+        for (int band = 0; band < bands; ++band) {
+            int above = src * bands + std::max(band - 1, 0);
+            int same = src * bands + band;
+            int below = src * bands + std::min(band + 1, bands - 1);
+            int written = dst * bands + band;
+            int start_row = bandStart(1, GRID_HEIGHT + 1, band, bands), end_row = bandStart(1, GRID_HEIGHT + 1, band + 1, bands);
+            #pragma omp task firstprivate(src, dst, start_row, end_row) \
+                depend(in: tiles.data()[above], tiles.data()[same], tiles.data()[below]) depend(out: tiles.data()[written])
+            {
+                tile_begin = start_row;
+                tile_end = end_row;
+                RULE.update(&TILE_BACKEND, *grids[src], *grids[dst]);
+            }
+        }
+    }
+
+    // An even number of generations ends in the starting grid
+    if (generations % 2 == 0)
+        std::swap(grid_current, grid_next);
+}
+
+#ifdef LAB2_PSTL
+// Chunks of rows per thread handed to the parallel algorithm, a few so idle threads can take over
+static const int PSTL_CHUNKS_PER_THREAD = 4;
+
+/*
+Runs a row task with the C++17 parallel algorithms: std::for_each with the
+parallel execution policy over chunk indices. Rows are grouped into chunks
+so kernels set up their per-call scratch buffers once per chunk rather than
+once per row. With TBB behind the standard library the parallelism is
+capped at NUM_THREADS; otherwise the library decides, and libstdc++ without
+TBB runs the chunks in order.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- task: Work to run on each chunk of rows.
+
+Returns:
+- void
+*/
+void runRowsPSTL(int begin, int end, const RowTask& task) {
+    int chunks = std::min(end - begin, NUM_THREADS * PSTL_CHUNKS_PER_THREAD);
+    if (chunks <= 0)
+        return;
+    std::vector<int> indices(chunks);
+    std::iota(indices.begin(), indices.end(), 0);
+#ifdef LAB2_PSTL_TBB
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, NUM_THREADS);
+#endif
+    std::for_each(std::execution::par, indices.begin(), indices.end(), [&](int chunk) {
+        int start_row = begin + static_cast<int>(static_cast<long long>(end - begin) * chunk / chunks);
+        int end_row = begin + static_cast<int>(static_cast<long long>(end - begin) * (chunk + 1) / chunks);
+#ifdef LAB2_PSTL_TBB
+        runTimed(tbb::this_task_arena::current_thread_index(), task, start_row, end_row);
+#else
+        runTimed(0, task, start_row, end_row);
+#endif
+    });
+}
+#endif
+
+#ifdef LAB2_TBB
+// Smallest tiles the TBB backend splits further: rows, and cells per row so each tile keeps full vector loops
+static const int TBB_ROW_GRAIN = 16;
+static const int TBB_COLUMN_GRAIN = 1024;
+
+/*
+Runs a row task with Intel TBB: tbb::parallel_for over the rows, split by
+the auto partitioner. At most NUM_THREADS threads take part.
+
+Parameters:
+- begin: First row of the range.
+- end: Row after the last one in the range.
+- task: Work to run on each range of rows.
+
+Returns:
+- void
+*/
+void runRowsTBB(int begin, int end, const RowTask& task) {
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, NUM_THREADS);
+    tbb::parallel_for(tbb::blocked_range<int>(begin, end), [&](const tbb::blocked_range<int>& rows) {
+        runTimed(tbb::this_task_arena::current_thread_index(), task, rows.begin(), rows.end());
+    });
+}
+
+/*
+Runs a tile task with Intel TBB: tbb::parallel_for over a blocked_range2d
+of the rectangle, which the auto partitioner splits along rows and columns
+until the tiles reach the grain sizes. At most NUM_THREADS threads take
+part.
+
+Parameters:
+- y_begin: First row of the rectangle.
+- y_end: Row after the last one in the rectangle.
+- x_begin: First column of the rectangle.
+- x_end: Column after the last one in the rectangle.
+- task: Work to run on each tile.
+
+Returns:
+- void
+*/
+void runTilesTBB(int y_begin, int y_end, int x_begin, int x_end, const TileTask& task) {
+    tbb::global_control limit(tbb::global_control::max_allowed_parallelism, NUM_THREADS);
+    tbb::blocked_range2d<int> rectangle(y_begin, y_end, TBB_ROW_GRAIN, x_begin, x_end, TBB_COLUMN_GRAIN);
+    tbb::parallel_for(rectangle, [&](const tbb::blocked_range2d<int>& tile) {
+        auto start = std::chrono::steady_clock::now();
+        task(tile.rows().begin(), tile.rows().end(), tile.cols().begin(), tile.cols().end());
+        addBusyTime(tbb::this_task_arena::current_thread_index(), start);
+    });
+}
+#endif
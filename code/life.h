@@ -0,0 +1,118 @@
+/*
+Description:
+Grid layout, simulation settings and update backends shared by the
+Game of Life executable.
+*/
+
+#ifndef LIFE_H
+#define LIFE_H
+
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#include <utility>
+#include <functional>
+#include <atomic>
+#include <chrono>
+
+/*
+Allocator for grid storage. Memory comes from calloc, which hands out fresh
+zero pages for large blocks, and default construction is a no-op, so
+Grid(n) is zero-filled without touching a single page. Pages are first
+touched by whichever thread seeds or updates them.
+*/
+template <class T>
+struct ZeroPageAllocator {
+    typedef T value_type;
+
+    ZeroPageAllocator() {}
+    template <class U> ZeroPageAllocator(const ZeroPageAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        void* p = std::calloc(n, sizeof(T));
+        if (!p)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) { std::free(p); }
+
+    template <class U> void construct(U*) {}  // Already zero from calloc
+    template <class U, class... Args> void construct(U* p, Args&&... args) {
+        ::new (static_cast<void*>(p)) U(std::forward<Args>(args)...);
+    }
+};
+template <class T, class U> bool operator==(const ZeroPageAllocator<T>&, const ZeroPageAllocator<U>&) { return true; }
+template <class T, class U> bool operator!=(const ZeroPageAllocator<T>&, const ZeroPageAllocator<U>&) { return false; }
+
+// Padded grid storage: (GRID_HEIGHT + 2) rows of PITCH cells, one byte per cell
+typedef std::vector<uint8_t, ZeroPageAllocator<uint8_t>> Grid;
+
+// Grid size variables and thread count (set from the command line in main)
+extern int GRID_WIDTH;
+extern int GRID_HEIGHT;
+extern int PITCH;        // Row stride including the one-cell padding on each side
+extern int NUM_THREADS;
+
+// Work on padded rows [y_begin, y_end), one call per part of a parallel stage
+typedef std::function<void(int y_begin, int y_end)> RowTask;
+
+// Splits rows [begin, end) among the backend's threads and runs the task on each part
+typedef void (*RowScheduler)(int begin, int end, const RowTask& task);
+
+// Work on the padded cells [x_begin, x_end) of rows [y_begin, y_end)
+typedef std::function<void(int y_begin, int y_end, int x_begin, int x_end)> TileTask;
+
+// Splits the rectangle of rows [y_begin, y_end) and columns [x_begin, x_end) into tiles and runs the task on each
+typedef void (*TileScheduler)(int y_begin, int y_end, int x_begin, int x_end, const TileTask& task);
+
+// Computes several generations from grid_current at once, leaving the last one in grid_next (and grid_current as it was for one generation)
+typedef void (*GenerationRunner)(Grid& grid_current, Grid& grid_next, int generations);
+
+// Entry in the backend registry selected with -t
+struct Backend {
+    const char* name;                   // Processing type name used on the command line
+    RowScheduler run_rows;              // Runs every row-parallel stage of a generation
+    const char* thread_label;           // Used in the timing report, nullptr for single-threaded backends
+    GenerationRunner run_generations;   // Overlaps consecutive generations, nullptr to step them one at a time
+    TileScheduler run_tiles;            // Splits kernels that work on any rectangle in 2D, nullptr to split them by rows
+};
+
+extern const Backend BACKENDS[];
+extern const int NUM_BACKENDS;
+
+// Nanoseconds each backend thread spent running row tasks, by thread index (read by the status server)
+const int MAX_TIMED_THREADS = 256;
+extern std::atomic<long long> THREAD_BUSY_NS[MAX_TIMED_THREADS];
+void addBusyTime(int thread, std::chrono::steady_clock::time_point start);
+
+// Function Prototypes
+void setGridSize(int width, int height);
+uint64_t splitmix64(uint64_t& state);
+void seedRandomGrid(Grid& grid, uint64_t seed);
+uint64_t hashGrid(const Grid& grid);
+const Backend* findBackend(const std::string& name);
+void updateGrid(const Backend* backend, Grid& grid_current, Grid& grid_next);
+void advanceGrid(const Backend* backend, Grid& grid_current, Grid& grid_next, int generations);
+void updateRowsLife(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end);
+void updateTileLife(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end, int x_begin, int x_end);
+void runRowsSequential(int begin, int end, const RowTask& task);
+void runRowsThread(int begin, int end, const RowTask& task);
+void runRowsOMP(int begin, int end, const RowTask& task);
+void runRowsOMPTasks(int begin, int end, const RowTask& task);
+void runGenerationsOMPTasks(Grid& grid_current, Grid& grid_next, int generations);
+#ifdef LAB2_PSTL
+void runRowsPSTL(int begin, int end, const RowTask& task);
+#endif
+void runRowsPool(int begin, int end, const RowTask& task);
+void runGenerationsHybrid(Grid& grid_current, Grid& grid_next, int generations);
+#ifdef LAB2_TBB
+void runRowsTBB(int begin, int end, const RowTask& task);
+void runTilesTBB(int y_begin, int y_end, int x_begin, int x_end, const TileTask& task);
+#endif
+bool verifyBackends(int generations, uint64_t seed);
+bool benchmarkBackends(int generations, uint64_t seed);
+bool benchmarkSimd(int generations, uint64_t seed);
+
+#endif
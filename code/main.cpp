@@ -1,268 +1,613 @@
-/*
-Author: Rahil Vasa
-Last Date Modified: 10/05/2024
-Description:
-Parallel processing code for Game of Life.
-*/
-
-#include <SFML/Graphics.hpp>
-#include <vector>
-#include <cstdlib>
-#include <ctime>
-#include <omp.h>
-#include <iostream>
-#include <unistd.h>
-#include <chrono>
-#include <cstdint>
-#include <thread>
-#include <atomic>
-
-// Default values for window size, cell size, number of threads, and processing type
-int WINDOW_WIDTH = 800;
-int WINDOW_HEIGHT = 600;
-int PIXEL_SIZE = 5;
-int NUM_THREADS = 8;
-std::string PROCESSING_TYPE = "THRD";
-
-// Grid size variables calculated based on window dimensions and pixel size
-int GRID_WIDTH = WINDOW_WIDTH / PIXEL_SIZE;
-int GRID_HEIGHT = WINDOW_HEIGHT / PIXEL_SIZE;
-int PITCH = GRID_WIDTH + 2;  // Padding to eliminate boundary checks
-
-// Function Prototypes
-void seedRandomGrid(std::vector<uint8_t>& grid);
-void updateGridSequential(std::vector<uint8_t>& grid_current, std::vector<uint8_t>& grid_next);
-void updateGridThread(std::vector<uint8_t>& grid_current, std::vector<uint8_t>& grid_next);
-void updateGridOMP(std::vector<uint8_t>& grid_current, std::vector<uint8_t>& grid_next);
-
-void seedRandomGrid(std::vector<uint8_t>& grid) {
-    std::srand(static_cast<unsigned>(std::time(nullptr)));  // Seed random number generator
-    for (int y = 1; y <= GRID_HEIGHT; ++y) {  // Loop over rows
-        for (int x = 1; x <= GRID_WIDTH; ++x) {  // Loop over columns
-            grid[y * PITCH + x] = std::rand() % 2;  // Randomly set cell to 0 or 1
-        }
-    }
-}
-
-int main(int argc, char* argv[]) {
-    // Parse command-line arguments
-    int opt;
-    while ((opt = getopt(argc, argv, "n:c:x:y:t:")) != -1) {
-        switch (opt) {
-            case 'n':
-                NUM_THREADS = std::max(2, std::atoi(optarg));  // Set number of threads
-                break;
-            case 'c':
-                PIXEL_SIZE = std::max(1, std::atoi(optarg));  // Set pixel size
-                break;
-            case 'x':
-                WINDOW_WIDTH = std::atoi(optarg);  // Set window width
-                break;
-            case 'y':
-                WINDOW_HEIGHT = std::atoi(optarg);  // Set window height
-                break;
-            case 't':
-                PROCESSING_TYPE = optarg;  // Set processing type (SEQ, THRD, OMP)
-                break;
-            default:
-                std::cerr << "Usage: " << argv[0]
-                          << " [-n num_threads] [-c cell_size] [-x width] [-y height] [-t processing_type]\n";
-                exit(EXIT_FAILURE);
-        }
-    }
-
-    // Recalculate grid dimensions based on new window size and pixel size
-    GRID_WIDTH = WINDOW_WIDTH / PIXEL_SIZE;
-    GRID_HEIGHT = WINDOW_HEIGHT / PIXEL_SIZE;
-    PITCH = GRID_WIDTH + 2;  // Update pitch with padding
-
-    // Create SFML window
-    sf::RenderWindow window(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Game of Life");
-    window.setFramerateLimit(60);  // Limit framerate for smoother animation
-
-    // Initialize grids with padding
-    std::vector<uint8_t> grid_current((GRID_HEIGHT + 2) * PITCH, 0);  // Current grid state
-    std::vector<uint8_t> grid_next((GRID_HEIGHT + 2) * PITCH, 0);     // Next grid state
-
-    seedRandomGrid(grid_current);  // Seed the initial grid with random values
-
-    std::vector<uint8_t>* currentGrid = &grid_current;  // Pointer to current grid
-    std::vector<uint8_t>* nextGrid = &grid_next;        // Pointer to next grid
-
-    int generation_count = 0;  // Counter for generations
-    long long delta_t = 0;     // Time accumulator
-
-    while (window.isOpen()) {
-        // Handle events
-        sf::Event event;
-        while (window.pollEvent(event)) {
-            if (event.type == sf::Event::Closed)
-                window.close();  // Close window
-            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)
-                window.close();  // Close on Escape key
-        }
-
-        auto start = std::chrono::high_resolution_clock::now();  // Start timing
-
-        // Update the grid based on processing type
-        if (PROCESSING_TYPE == "SEQ") {
-            updateGridSequential(*currentGrid, *nextGrid);
-        } else if (PROCESSING_TYPE == "THRD") {
-            updateGridThread(*currentGrid, *nextGrid);
-        } else if (PROCESSING_TYPE == "OMP") {
-            updateGridOMP(*currentGrid, *nextGrid);
-        }
-
-        auto end = std::chrono::high_resolution_clock::now();  // End timing
-        delta_t += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();  // Accumulate time
-
-        generation_count++;  // Increment generation count
-        if (generation_count == 100) {
-            // Output performance data every 100 generations
-            std::cout << "100 generations took " << delta_t << " microseconds with ";
-            if (PROCESSING_TYPE == "SEQ")
-                std::cout << "single thread." << std::endl;
-            else if (PROCESSING_TYPE == "THRD")
-                std::cout << NUM_THREADS << " std::threads." << std::endl;
-            else if (PROCESSING_TYPE == "OMP")
-                std::cout << NUM_THREADS << " OMP threads." << std::endl;
-            generation_count = 0;
-            delta_t = 0;  // Reset time accumulator
-        }
-
-        // Swap the grids for the next iteration
-        std::swap(currentGrid, nextGrid);
-
-        // Display the current state of the grid
-        window.clear(sf::Color::Black);  // Clear window
-
-        sf::VertexArray cells(sf::Triangles);  // Vertex array for cells
-
-        // Loop over the grid and add alive cells to the vertex array
-        for (int y = 1; y <= GRID_HEIGHT; ++y) {
-            for (int x = 1; x <= GRID_WIDTH; ++x) {
-                if ((*currentGrid)[y * PITCH + x]) {
-                    float px = (x - 1) * PIXEL_SIZE;  // Calculate x position
-                    float py = (y - 1) * PIXEL_SIZE;  // Calculate y position
-
-                    // First triangle of the cell
-                    cells.append(sf::Vertex(sf::Vector2f(px, py), sf::Color::White));
-                    cells.append(sf::Vertex(sf::Vector2f(px + PIXEL_SIZE, py), sf::Color::White));
-                    cells.append(sf::Vertex(sf::Vector2f(px + PIXEL_SIZE, py + PIXEL_SIZE), sf::Color::White));
-
-                    // Second triangle of the cell
-                    cells.append(sf::Vertex(sf::Vector2f(px, py), sf::Color::White));
-                    cells.append(sf::Vertex(sf::Vector2f(px + PIXEL_SIZE, py + PIXEL_SIZE), sf::Color::White));
-                    cells.append(sf::Vertex(sf::Vector2f(px, py + PIXEL_SIZE), sf::Color::White));
-                }
-            }
-        }
-        window.draw(cells);  // Draw all cells at once
-        window.display();    // Display on screen
-    }
-
-    return 0;
-}
-
-/*
-Updates the grid for the next generation using sequential processing.
-Iterates over each cell and applies the Game of Life rules.
-
-Parameters:
-- grid_current: Reference to the current grid state.
-- grid_next: Reference to the grid where the next state will be stored.
-
-Returns:
-- void
-*/
-void updateGridSequential(std::vector<uint8_t>& grid_current, std::vector<uint8_t>& grid_next) {
-    for (int y = 1; y <= GRID_HEIGHT; ++y) {
-        int idx = y * PITCH + 1;  // Calculate starting index for the row
-        for (int x = 1; x <= GRID_WIDTH; ++x, ++idx) {
-            // Count the number of alive neighbors
-            int neighbors = grid_current[idx - PITCH - 1] + grid_current[idx - PITCH] + grid_current[idx - PITCH + 1]
-                          + grid_current[idx - 1] + grid_current[idx + 1]
-                          + grid_current[idx + PITCH - 1] + grid_current[idx + PITCH] + grid_current[idx + PITCH + 1];
-            // Apply the Game of Life rules
-            grid_next[idx] = (grid_current[idx]) ? (neighbors == 2 || neighbors == 3) : (neighbors == 3);
-        }
-    }
-}
-
-/*
-Updates the grid for the next generation using multiple threads.
-Divides the work among threads by splitting the grid into chunks.
-
-Parameters:
-- grid_current: Reference to the current grid state.
-- grid_next: Reference to the grid where the next state will be stored.
-
-Returns:
-- void
-*/
-void updateGridThread(std::vector<uint8_t>& grid_current, std::vector<uint8_t>& grid_next) {
-    // Calculate total number of cells
-    int total_cells = GRID_HEIGHT * GRID_WIDTH;
-    int cells_per_thread = total_cells / NUM_THREADS;  // Cells per thread
-    int extra_cells = total_cells % NUM_THREADS;       // Extra cells to distribute
-
-    std::vector<std::thread> threads;  // Vector to hold threads
-
-    // Lambda function for thread work
-    auto worker = [&](int start_idx, int end_idx) {
-        for (int idx = start_idx; idx < end_idx; ++idx) {
-            int y = idx / GRID_WIDTH + 1;           // Calculate y coordinate
-            int x = idx % GRID_WIDTH + 1;           // Calculate x coordinate
-            int grid_idx = y * PITCH + x;           // Calculate grid index
-            // Count the number of alive neighbors
-            int neighbors = grid_current[grid_idx - PITCH - 1] + grid_current[grid_idx - PITCH] + grid_current[grid_idx - PITCH + 1]
-                          + grid_current[grid_idx - 1] + grid_current[grid_idx + 1]
-                          + grid_current[grid_idx + PITCH - 1] + grid_current[grid_idx + PITCH] + grid_current[grid_idx + PITCH + 1];
-            // Apply the Game of Life rules
-            grid_next[grid_idx] = (grid_current[grid_idx]) ? (neighbors == 2 || neighbors == 3) : (neighbors == 3);
-        }
-    };
-
-    int start_idx = 0;  // Starting index for each thread
-    for (int i = 0; i < NUM_THREADS; ++i) {
-        // Calculate end index for this thread
-        int end_idx = start_idx + cells_per_thread + (i < extra_cells ? 1 : 0);
-        // Create and start the thread
-        threads.emplace_back(worker, start_idx, end_idx);
-        start_idx = end_idx;  // Update start index for next thread
-    }
-
-    // Wait for all threads to finish
-    for (auto& t : threads) {
-        t.join();
-    }
-}
-
-/*
-Updates the grid for the next generation using OpenMP for parallel processing.
-Uses a parallel for loop to divide work among threads automatically.
-
-Parameters:
-- grid_current: Reference to the current grid state.
-- grid_next: Reference to the grid where the next state will be stored.
-
-Returns:
-- void
-*/
-void updateGridOMP(std::vector<uint8_t>& grid_current, std::vector<uint8_t>& grid_next) {
-    int total_cells = GRID_HEIGHT * GRID_WIDTH;  // Total number of cells
-
-    // Parallel for loop with OpenMP
-    #pragma omp parallel for schedule(static) num_threads(NUM_THREADS)
-    for (int idx = 0; idx < total_cells; ++idx) {
-        int y = idx / GRID_WIDTH + 1;           // Calculate y coordinate
-        int x = idx % GRID_WIDTH + 1;           // Calculate x coordinate
-        int grid_idx = y * PITCH + x;           // Calculate grid index
-        // Count the number of alive neighbors
-        int neighbors = grid_current[grid_idx - PITCH - 1] + grid_current[grid_idx - PITCH] + grid_current[grid_idx - PITCH + 1]
-                      + grid_current[grid_idx - 1] + grid_current[grid_idx + 1]
-                      + grid_current[grid_idx + PITCH - 1] + grid_current[grid_idx + PITCH] + grid_current[grid_idx + PITCH + 1];
-        // Apply the Game of Life rules
-        grid_next[grid_idx] = (grid_current[grid_idx]) ? (neighbors == 2 || neighbors == 3) : (neighbors == 3);
-    }
-}
+/*
+Author: Rahil Vasa
+Last Date Modified: 10/05/2024
+Description:
+Parallel processing code for Game of Life.
+*/
+
+#include <SFML/Graphics.hpp>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <iostream>
+#include <unistd.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <cmath>
+#include <thread>
+#include "life.h"
+#include "rules.h"
+#include "export.h"
+#include "render.h"
+#include "edit.h"
+#include "history.h"
+#include "stats.h"
+#include "snapshot.h"
+#include "shm.h"
+#include "server.h"
+#include "pipeline.h"
+#include "volume.h"
+#include "topology.h"
+
+// Default values for window size, cell size and processing type
+int WINDOW_WIDTH = 800;
+int WINDOW_HEIGHT = 600;
+int PIXEL_SIZE = 5;
+std::string PROCESSING_TYPE = "THRD";
+std::string DISPLAY_MODE = "TEX";
+
+/*
+Prints the time taken by the last 100 generations for the selected backend,
+followed by the kernel throughput in cells per second (voxels for 3D rules)
+and the simulation and frame rates over the same period.
+
+Parameters:
+- delta_t: Accumulated kernel time in microseconds.
+- backend: Backend that computed the generations.
+- wall_seconds: Wall time taken by the 100 generations, including drawing.
+- frames: Frames drawn or exported during that time.
+
+Returns:
+- void
+*/
+static void printTiming(long long delta_t, const Backend* backend, double wall_seconds, int frames) {
+    std::cout << "100 generations took " << delta_t << " microseconds with ";
+    if (!backend->thread_label)
+        std::cout << "single thread.";
+    else
+        std::cout << NUM_THREADS << " " << backend->thread_label << ".";
+    if (delta_t > 0)
+        std::cout << " " << static_cast<int>(100.0 * GRID_WIDTH * GRID_HEIGHT * (RULE.volume ? GRID_DEPTH : 1) / delta_t) << " Mcells/s";
+    if (wall_seconds > 0)
+        std::cout << " (" << static_cast<int>(100 / wall_seconds) << " gens/s, "
+                  << static_cast<int>(frames / wall_seconds) << " frames/s)";
+    std::cout << std::endl;
+}
+
+/*
+Prints the number of exported frames and the end-to-end simulation rate of
+a headless run, which includes every stage of each generation.
+
+Parameters:
+- exporter: Reference to the finished exporter.
+- path: Export target.
+- generations: Generations computed.
+- start: Time the first generation started.
+
+Returns:
+- void
+*/
+static void printExportSummary(const FrameExporter& exporter, const std::string& path, int generations,
+                               std::chrono::high_resolution_clock::time_point start) {
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << "Exported " << exporter.framesWritten() << " frames to " << path << " in " << seconds << " s";
+    if (seconds > 0)
+        std::cout << " (" << static_cast<int>(generations / seconds) << " gens/s end to end)";
+    std::cout << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    auto program_start = std::chrono::high_resolution_clock::now();  // Start of the startup measurement
+
+    // Parse command-line arguments
+    int opt;
+    uint64_t seed = static_cast<uint64_t>(std::time(nullptr));  // Seed for the initial grid
+    int num_threads = 0;                                        // Compute threads, 0 uses one per physical core
+    int verify_generations = 0;                                 // Run the backend check instead of the window
+    int benchmark_generations = 0;                              // Run the benchmarks instead of the window
+    std::string export_path;                                    // Headless export target (.y4m or PNG prefix)
+    int export_generations = 1000;                              // Generations to simulate when exporting
+    int export_every = 1;                                       // Export every Nth generation
+    int encoder_threads = 2;                                    // Threads encoding exported frames
+    int grid_width = 0, grid_height = 0;                        // Grid size, 0 derives it from the window
+    RenderPolicy render_policy;                                 // When frames are drawn, 60 fps by default
+    int history_depth = 0;                                      // Generations kept for rewinding, 0 disables
+    std::string shm_name;                                       // Shared-memory live view, empty disables
+    int server_port = 0;                                        // Status server port on 127.0.0.1, 0 disables
+    std::string checkpoint_path;                                // Checkpoint to start from instead of a random grid
+    bool pipelined = false;                                     // Export through the coroutine pipeline
+    bool flow_graph = false;                                    // Export through the TBB flow graph
+    while ((opt = getopt(argc, argv, "n:c:x:y:t:s:v:B:e:g:f:j:d:W:H:D:R:b:r:m:p:L:aG")) != -1) {
+        switch (opt) {
+            case 'n':
+                num_threads = std::max(1, std::atoi(optarg));  // Set number of threads
+                break;
+            case 'c':
+                PIXEL_SIZE = std::max(1, std::atoi(optarg));  // Set pixel size
+                break;
+            case 'x':
+                WINDOW_WIDTH = std::atoi(optarg);  // Set window width
+                break;
+            case 'y':
+                WINDOW_HEIGHT = std::atoi(optarg);  // Set window height
+                break;
+            case 't':
+                PROCESSING_TYPE = optarg;  // Set processing type (SEQ, THRD, OMP)
+                break;
+            case 's':
+                seed = std::strtoull(optarg, nullptr, 10);  // Set random seed
+                break;
+            case 'v':
+                verify_generations = std::max(1, std::atoi(optarg));  // Set generations per verification run
+                break;
+            case 'B':
+                benchmark_generations = std::max(1, std::atoi(optarg));  // Set generations per benchmark variant
+                break;
+            case 'e':
+                export_path = optarg;  // Set export target and run without a window
+                break;
+            case 'g':
+                export_generations = std::max(0, std::atoi(optarg));  // Set generations to export
+                break;
+            case 'f':
+                export_every = std::max(1, std::atoi(optarg));  // Set export interval
+                break;
+            case 'j':
+                encoder_threads = std::max(1, std::atoi(optarg));  // Set encoder thread count
+                break;
+            case 'd':
+                DISPLAY_MODE = optarg;  // Set display mode (TEX, VTX)
+                break;
+            case 'R':
+                if (!render_policy.parse(optarg)) {  // Set render policy (fps:N, every:N, demand)
+                    std::cerr << "Invalid render policy " << optarg << ". Use fps:N, every:N or demand." << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'r':
+                if (!parseRule(optarg, RULE)) {  // Set rule (B3/S23, B2/S/C3, /2/3, B2-a/S12, B2/S34H, R5,C0,M1,S34..58,B34..45,NM, LENIA, ...)
+                    std::cerr << "Invalid rule " << optarg << ". Use B/S notation (B3/S23, B2/S/C3, B2-a/S12, B2/S34H), S/B/C (23/3, /2/3)"
+                              << ", Larger than Life (R5,C0,M1,S34..58,B34..45,NM), Lenia (LENIA,R13,T10,M0.15,S0.015) or 3D (3D4555)." << std::endl;
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'b':
+                history_depth = std::max(0, std::atoi(optarg));  // Set rewind history depth
+                break;
+            case 'm':
+                shm_name = optarg[0] == '/' ? optarg : std::string("/") + optarg;  // Set the shared-memory name of the live view
+                break;
+            case 'p':
+                server_port = std::max(0, std::atoi(optarg));  // Set the status server port
+                break;
+            case 'L':
+                checkpoint_path = optarg;  // Set the checkpoint to load
+                break;
+            case 'a':
+#ifdef LAB2_COROUTINES
+                pipelined = true;  // Run headless export as a coroutine pipeline
+#else
+                std::cerr << "The coroutine pipeline (-a) needs a build with -DLAB2_COROUTINES=ON." << std::endl;
+                exit(EXIT_FAILURE);
+#endif
+                break;
+            case 'G':
+#ifdef LAB2_TBB
+                flow_graph = true;  // Run headless export as a TBB flow graph
+#else
+                std::cerr << "The flow graph (-G) needs a build with TBB installed." << std::endl;
+                exit(EXIT_FAILURE);
+#endif
+                break;
+            case 'W':
+                grid_width = std::max(1, std::atoi(optarg));  // Set grid width in cells
+                break;
+            case 'H':
+                grid_height = std::max(1, std::atoi(optarg));  // Set grid height in cells
+                break;
+            case 'D':
+                GRID_DEPTH = std::max(1, std::atoi(optarg));  // Set volume depth in cells for 3D rules
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0]
+                          << " [-n num_threads] [-c cell_size] [-x width] [-y height] [-t processing_type]"
+                          << " [-s seed] [-v verify_generations] [-B benchmark_generations]"
+                          << " [-e export_path] [-g generations] [-f export_every] [-j encoder_threads]"
+                          << " [-d display_mode] [-W grid_width] [-H grid_height] [-D grid_depth] [-R render_policy] [-b history_depth] [-r rule] [-m shm_name] [-p server_port] [-L checkpoint] [-a] [-G]\n";
+                exit(EXIT_FAILURE);
+        }
+    }
+
+    // 3D rules show the middle slice; rewinding a slice cannot rewind the volume behind it, so history is off
+    if (RULE.volume) {
+        VOLUME_SLICE = GRID_DEPTH / 2;
+        history_depth = 0;
+    }
+
+    // Without -n, one compute thread per physical core: SMT siblings share the execution units the kernels saturate
+    NUM_THREADS = num_threads > 0 ? num_threads : cpuTopology().physical_cores;
+
+    if (pipelined && (export_path.empty() || server_port > 0)) {
+        std::cerr << "The coroutine pipeline (-a) runs headless exports (-e) without the status server (-p)." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (flow_graph && (export_path.empty() || server_port > 0 || pipelined)) {
+        std::cerr << "The flow graph (-G) runs headless exports (-e) without the status server (-p) or the coroutine pipeline (-a)." << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    // Compare every backend against the reference implementation and exit
+    if (verify_generations > 0)
+        return verifyBackends(verify_generations, seed) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    const Backend* backend = findBackend(PROCESSING_TYPE);
+    if (!backend) {
+        std::cerr << "Unknown processing type " << PROCESSING_TYPE << ". Available:";
+        for (int i = 0; i < NUM_BACKENDS; ++i)
+            std::cerr << " " << BACKENDS[i].name;
+        std::cerr << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    if (backend->thread_label)
+        warnOversubscription(NUM_THREADS, backend->thread_label);
+
+    // A checkpoint sets the grid size and replaces the random grid
+    std::vector<uint8_t> checkpoint;
+    if (!checkpoint_path.empty()) {
+        if (RULE.volume) {
+            std::cerr << "Checkpoints hold 2D grids and cannot start a 3D rule." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        std::string checkpoint_rule, error;
+        if (!readCheckpoint(checkpoint_path, checkpoint, grid_width, grid_height, checkpoint_rule)) {
+            std::cerr << "Cannot read checkpoint " << checkpoint_path << "." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        if (!checkCheckpointRule(checkpoint, grid_width, checkpoint_rule, error)) {
+            std::cerr << "Cannot start from checkpoint " << checkpoint_path << ": " << error << "." << std::endl;
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    // Grid dimensions default to filling the window at the chosen pixel size
+    setGridSize(grid_width ? grid_width : WINDOW_WIDTH / PIXEL_SIZE,
+                grid_height ? grid_height : WINDOW_HEIGHT / PIXEL_SIZE);
+
+    // Time every backend, and for B3/S23 the vectorized loops, on this grid size and exit
+    if (benchmark_generations > 0) {
+        bool same = benchmarkBackends(benchmark_generations, seed);
+        if (RULE.name == "B3/S23")
+            same = benchmarkSimd(benchmark_generations, seed) && same;
+        return same ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    // Initialize grids with padding, zero-filled by the allocator without touching their pages
+    size_t grid_cells = static_cast<size_t>(GRID_HEIGHT + 2) * PITCH;
+    Grid grid_current(grid_cells);  // Current grid state
+    Grid grid_next(grid_cells);     // Next grid state
+    auto allocated = std::chrono::high_resolution_clock::now();
+
+    // Seed the initial grid in parallel on a helper thread while the window is created
+    double seed_ms = 0;
+    std::thread seeder([&] {
+        auto seed_start = std::chrono::high_resolution_clock::now();
+        if (checkpoint.empty())
+            seedRandomGrid(grid_current, seed);  // Seed the initial grid with random values
+        for (int y = 0; y < GRID_HEIGHT && !checkpoint.empty(); ++y)
+            std::copy(&checkpoint[static_cast<size_t>(y) * GRID_WIDTH], &checkpoint[static_cast<size_t>(y) * GRID_WIDTH] + GRID_WIDTH,
+                      &grid_current[static_cast<size_t>(y + 1) * PITCH + 1]);
+        seed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - seed_start).count();
+    });
+    sf::RenderWindow window;  // Only opened when not exporting
+    if (export_path.empty())
+        window.create(sf::VideoMode(WINDOW_WIDTH, WINDOW_HEIGHT), "Game of Life");  // Create SFML window
+    double window_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - allocated).count();
+    seeder.join();
+
+    auto ready = std::chrono::high_resolution_clock::now();
+    std::cout << "Startup took " << std::chrono::duration<double, std::milli>(ready - program_start).count() << " ms for "
+              << static_cast<long long>(GRID_WIDTH) * GRID_HEIGHT * (RULE.volume ? GRID_DEPTH : 1) << " cells (allocate "
+              << std::chrono::duration<double, std::milli>(allocated - program_start).count() << " ms, seed " << seed_ms
+              << " ms, window " << window_ms << " ms)" << std::endl;
+
+    Grid* currentGrid = &grid_current;  // Pointer to current grid
+    Grid* nextGrid = &grid_next;        // Pointer to next grid
+
+    int generation_count = 0;  // Counter for generations
+    long long delta_t = 0;     // Time accumulator
+    int frame_count = 0;       // Frames drawn or exported since the last report
+    auto report_start = std::chrono::high_resolution_clock::now();  // Start of the reporting period
+    SnapshotPublisher snapshots;  // Hands completed generations to reader threads
+
+    // Other processes can watch the run through shared memory
+    std::unique_ptr<SharedGridWriter> live_view;
+    if (!shm_name.empty()) {
+        live_view.reset(new SharedGridWriter(shm_name, snapshots.subscribe()));
+        if (!live_view->ok())
+            exit(EXIT_FAILURE);
+    }
+
+    // Local HTTP server for inspecting and steering the run
+    std::unique_ptr<StatusServer> server;
+    if (server_port > 0) {
+        server.reset(new StatusServer(server_port, snapshots.subscribe(), backend->name, backend->thread_label ? NUM_THREADS : 1));
+        if (!server->ok())
+            exit(EXIT_FAILURE);
+        std::cout << "Status server on http://127.0.0.1:" << server_port << "/" << std::endl;
+    }
+
+    if (!export_path.empty()) {
+        // Headless export: the simulation only copies frames out, encoding happens on the exporter's threads
+        FrameExporter exporter(export_path, PIXEL_SIZE, encoder_threads);
+        auto export_start = std::chrono::high_resolution_clock::now();
+#ifdef LAB2_COROUTINES
+        if (pipelined) {
+            // The same stages as the loop below, run as overlapping coroutines
+            runPipelinedExport(backend, *currentGrid, exporter, snapshots, export_generations, export_every,
+                               [backend](long long delta_t, double wall_seconds, int frames) { printTiming(delta_t, backend, wall_seconds, frames); });
+            exporter.finish();
+            printExportSummary(exporter, export_path, export_generations, export_start);
+            return exporter.ok() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+#endif
+#ifdef LAB2_TBB
+        if (flow_graph) {
+            // The same stages as the loop below, as nodes of a TBB flow graph
+            runFlowGraphExport(backend, *currentGrid, exporter, snapshots, export_generations, export_every,
+                               [backend](long long delta_t, double wall_seconds, int frames) { printTiming(delta_t, backend, wall_seconds, frames); });
+            exporter.finish();
+            printExportSummary(exporter, export_path, export_generations, export_start);
+            return exporter.ok() ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+#endif
+        exporter.submit(*currentGrid, 0);
+        snapshots.publish(*currentGrid, 0, true);
+        bool paused = false;  // Only the status server pauses headless runs
+        int generations_run = 0;
+        for (int generation = 1; generation <= export_generations && exporter.ok(); ++generation) {
+            // Take the server's requests between generations, waiting here while it holds the run
+            while (server) {
+                int pause = server->takePauseRequest();
+                if (pause >= 0)
+                    paused = pause == 1;
+                int every = server->takeGensPerFrameRequest();
+                if (every > 0)
+                    export_every = every;
+                server->report(paused, export_every);
+                if (!paused)
+                    break;
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            }
+
+            // Backends that overlap generations get every one up to the next frame or timing report at once
+            int batch = 1;
+            if (backend->run_generations)
+                batch = std::min(std::min(export_every - (generation - 1) % export_every, 100 - generation_count),
+                                 export_generations - generation + 1);
+
+            auto start = std::chrono::high_resolution_clock::now();  // Start timing
+            advanceGrid(backend, *currentGrid, *nextGrid, batch);
+            auto end = std::chrono::high_resolution_clock::now();  // End timing
+            delta_t += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();  // Accumulate time
+            generation += batch - 1;
+
+            std::swap(currentGrid, nextGrid);
+            snapshots.publish(*currentGrid, generation, generation % export_every == 0);  // Every reader on exported frames
+            if (generation % export_every == 0) {
+                exporter.submit(*currentGrid, generation);
+                frame_count++;
+            }
+
+            generation_count += batch;
+            if (generation_count == 100) {
+                printTiming(delta_t, backend, std::chrono::duration<double>(end - report_start).count(), frame_count);
+                generation_count = 0;
+                delta_t = 0;  // Reset time accumulator
+                frame_count = 0;
+                report_start = end;
+            }
+            generations_run = generation;
+        }
+        exporter.finish();
+        printExportSummary(exporter, export_path, generations_run, export_start);
+        return exporter.ok() ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    std::unique_ptr<Renderer> renderer(createRenderer(DISPLAY_MODE));
+    if (!renderer) {
+        std::cerr << "Unknown display mode " << DISPLAY_MODE << ". Available: TEX VTX" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+
+    Viewport view;             // Starts at the top-left corner, one cell per PIXEL_SIZE pixels
+    view.zoom = PIXEL_SIZE;
+    DensityPyramid density;    // Summaries drawn instead of cells when zoomed out
+    density.resize();
+    TRACKED_DENSITY = &density;  // The kernels mark the tiles each generation changes
+    bool panning = false;      // Right mouse button held
+    sf::Vector2i pan_from;     // Last mouse position while panning
+    bool redraw = true;        // Input changed the view, draw even if the policy is not due
+    EditQueue edits;           // Painted cells waiting to be applied between generations
+    bool painting = false;     // Left mouse button held
+    const uint8_t live_state = RULE.continuous ? 255 : 1;  // Full level for Lenia
+    uint8_t paint_state = live_state;  // Paints live cells, 0 (Shift held) erases
+    sf::Vector2i paint_from;   // Last painted cell
+    bool paused = false;       // Space toggles, Right steps forward, Left rewinds
+    int step_requests = 0;     // Single steps queued while paused
+    long long generation = 0;  // Generation shown, decreases when rewinding
+    ThroughputStats stats;     // Moving averages shown in the window title
+    PopulationCounter population(snapshots.subscribe());  // Counts live cells off the simulation thread
+    bool publish = true;       // The grid changed since it was last published to every reader
+    std::unique_ptr<History> history(history_depth > 0 ? new History(history_depth) : nullptr);
+    int generations_since_frame = 0;
+    auto last_frame = std::chrono::high_resolution_clock::now();
+    auto last_poll = last_frame;
+    auto last_title = last_frame;
+
+    while (window.isOpen()) {
+        // Handle events, at most every few milliseconds so fast backends are not held up by the event queue
+        auto now = std::chrono::high_resolution_clock::now();
+        sf::Event event;
+        bool poll = now - last_poll >= std::chrono::milliseconds(5);
+        if (poll)
+            last_poll = now;
+        while (poll && window.pollEvent(event)) {
+            if (event.type == sf::Event::Closed)
+                window.close();  // Close window
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Escape)
+                window.close();  // Close on Escape key
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Space) {
+                paused = !paused;  // Pause or resume
+                step_requests = 0;
+                redraw = true;
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Right) {
+                paused = true;  // Step one generation forward
+                step_requests++;
+            }
+            if (event.type == sf::Event::KeyPressed && event.key.code == sf::Keyboard::Left) {
+                paused = true;  // Step one generation back
+                step_requests = 0;
+                if (history && history->rewind(*currentGrid)) {
+                    generation--;
+                    density.markAllDirty();
+                    publish = true;
+                }
+                redraw = true;
+            }
+            if (RULE.volume && event.type == sf::Event::KeyPressed &&
+                (event.key.code == sf::Keyboard::Up || event.key.code == sf::Keyboard::Down)) {
+                // Keep edits made on the shown slice, then show the next one up or down
+                writeVolumeSlice(VOLUME_SLICE, *currentGrid);
+                VOLUME_SLICE = std::min(GRID_DEPTH - 1, std::max(0, VOLUME_SLICE + (event.key.code == sf::Keyboard::Up ? 1 : -1)));
+                readVolumeSlice(VOLUME_SLICE, *currentGrid);
+                density.markAllDirty();
+                publish = true;
+                redraw = true;
+            }
+            if (event.type == sf::Event::Resized) {  // Keep one view unit per window pixel
+                window.setView(sf::View(sf::FloatRect(0, 0, event.size.width, event.size.height)));
+                redraw = true;
+            }
+            if (event.type == sf::Event::MouseWheelScrolled) {  // Zoom around the cursor
+                view.zoomAt(event.mouseWheelScroll.delta > 0 ? 1.25 : 0.8, event.mouseWheelScroll.x, event.mouseWheelScroll.y);
+                redraw = true;
+            }
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Right) {
+                panning = true;  // Start dragging the view
+                pan_from = sf::Vector2i(event.mouseButton.x, event.mouseButton.y);
+            }
+            if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Right)
+                panning = false;
+            if (event.type == sf::Event::MouseButtonPressed && event.mouseButton.button == sf::Mouse::Left) {
+                painting = true;  // Start a brush stroke
+                paint_state = (sf::Keyboard::isKeyPressed(sf::Keyboard::LShift) || sf::Keyboard::isKeyPressed(sf::Keyboard::RShift)) ? 0 : live_state;
+                paint_from = view.cellAt(event.mouseButton.x, event.mouseButton.y);
+                edits.pushStroke(paint_from.x, paint_from.y, paint_from.x, paint_from.y, paint_state, static_cast<int>(std::ceil(1 / view.zoom)));
+                redraw = true;
+            }
+            if (event.type == sf::Event::MouseButtonReleased && event.mouseButton.button == sf::Mouse::Left)
+                painting = false;
+            if (event.type == sf::Event::MouseMoved && painting) {
+                sf::Vector2i cell = view.cellAt(event.mouseMove.x, event.mouseMove.y);
+                edits.pushStroke(paint_from.x, paint_from.y, cell.x, cell.y, paint_state, static_cast<int>(std::ceil(1 / view.zoom)));
+                paint_from = cell;
+                redraw = true;
+            }
+            if (event.type == sf::Event::MouseMoved && panning) {
+                view.pan(event.mouseMove.x - pan_from.x, event.mouseMove.y - pan_from.y);
+                pan_from = sf::Vector2i(event.mouseMove.x, event.mouseMove.y);
+                redraw = true;
+            }
+        }
+
+        // Painted cells take effect between generations; the history keeps the unedited grid for rewinding
+        if (history && edits.hasPending())
+            history->saveBase(*currentGrid);
+        if (edits.apply(*currentGrid, density)) {
+            publish = true;
+            if (paused)
+                redraw = true;
+        }
+
+        // Requests from the status server; generations per frame switch the render policy to every:N
+        if (server) {
+            int pause = server->takePauseRequest();
+            if (pause >= 0 && (pause == 1) != paused) {
+                paused = pause == 1;
+                step_requests = 0;
+                redraw = true;
+            }
+            int every = server->takeGensPerFrameRequest();
+            if (every > 0) {
+                render_policy.mode = RenderPolicy::EVERY;
+                render_policy.value = every;
+            }
+            server->report(paused, render_policy.mode == RenderPolicy::EVERY ? render_policy.value : 0);
+        }
+
+        auto end = std::chrono::high_resolution_clock::now();
+        if (!paused || step_requests > 0) {
+            if (step_requests > 0)
+                step_requests--;
+
+            auto start = std::chrono::high_resolution_clock::now();  // Start timing
+
+            // Update the grid with the selected backend
+            updateGrid(backend, *currentGrid, *nextGrid);
+
+            end = std::chrono::high_resolution_clock::now();  // End timing
+            delta_t += std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();  // Accumulate time
+            stats.addGeneration(std::chrono::duration<double>(end - start).count());
+
+            generation_count++;  // Increment generation count
+            if (generation_count == 100) {
+                // Output performance data every 100 generations
+                printTiming(delta_t, backend, std::chrono::duration<double>(end - report_start).count(), frame_count);
+                generation_count = 0;
+                delta_t = 0;  // Reset time accumulator
+                frame_count = 0;
+                report_start = end;
+            }
+
+            if (history)
+                history->record(*currentGrid, *nextGrid);  // Keep the delta for rewinding
+
+            // Swap the grids for the next iteration
+            std::swap(currentGrid, nextGrid);
+            generations_since_frame++;
+            generation++;
+            publish = true;
+            if (paused)
+                redraw = true;  // Show single steps immediately
+        } else if (!redraw) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));  // Nothing to do while paused
+        }
+
+        // Display the latest state only when the render policy asks for a frame (or on any change while paused)
+        double since_frame = std::chrono::duration<double>(end - last_frame).count();
+        bool frame_due = paused ? redraw : render_policy.due(generations_since_frame, since_frame, redraw);
+        if (frame_due) {
+            auto render_start = std::chrono::high_resolution_clock::now();
+            window.clear(sf::Color::Black);  // Clear window
+            renderer->draw(window, *currentGrid, view, density);  // Draw the visible part of the grid
+            window.display();    // Display on screen
+            stats.addFrame(std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - render_start).count());
+            frame_count++;
+            generations_since_frame = 0;
+            redraw = false;
+            last_frame = end;
+        }
+
+        // Refresh the title twice a second; setTitle is too slow to call every generation
+        bool title_due = end - last_title >= std::chrono::milliseconds(500);
+        if (title_due) {
+            stats.sampleRates(std::chrono::duration<double>(end - last_title).count());
+            std::string title = stats.summary(backend->name, backend->thread_label ? NUM_THREADS : 1, generation, paused, population.population());
+            if (RULE.volume)
+                title += " | slice " + std::to_string(VOLUME_SLICE) + "/" + std::to_string(GRID_DEPTH);
+            window.setTitle(title);
+            last_title = end;
+        }
+
+        // Copy the grid only for readers that took their last snapshot; the rest catch up on frames and title refreshes
+        if (publish) {
+            snapshots.publish(*currentGrid, generation, frame_due || title_due);
+            publish = !(frame_due || title_due);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,268 @@
+/*
+Description:
+Coroutine scheduler and the four-stage headless export pipeline.
+*/
+
+#ifdef LAB2_COROUTINES
+
+#include "pipeline.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Coroutine that starts right away and frees its frame when it finishes
+struct Job {
+    struct promise_type {
+        Job get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+};
+
+/*
+A fixed set of worker threads resuming coroutines from a queue. A coroutine
+moves onto a worker with co_await scheduler.schedule().
+*/
+class Scheduler {
+public:
+    explicit Scheduler(int num_workers) {
+        for (int i = 0; i < num_workers; ++i)
+            workers.emplace_back(&Scheduler::work, this);
+    }
+
+    ~Scheduler() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        ready.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    auto schedule() {
+        struct Awaiter {
+            Scheduler& scheduler;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) { scheduler.post(handle); }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+private:
+    void post(std::coroutine_handle<> handle) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            queue.push_back(handle);
+        }
+        ready.notify_one();
+    }
+
+    void work() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            ready.wait(lock, [this] { return stopping || !queue.empty(); });
+            if (queue.empty())
+                return;
+            std::coroutine_handle<> handle = queue.front();
+            queue.pop_front();
+            lock.unlock();
+            handle.resume();
+            lock.lock();
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::deque<std::coroutine_handle<>> queue;
+    std::mutex mutex;
+    std::condition_variable ready;
+    bool stopping = false;
+};
+
+/*
+One-shot event with a single waiting coroutine. set() resumes the waiter
+on the setting thread, which only moves it back onto the scheduler. The
+state is null while unset, the event itself once set, and the waiter's
+handle while one is suspended.
+*/
+class StageEvent {
+public:
+    auto operator co_await() noexcept {
+        struct Awaiter {
+            StageEvent& event;
+            bool await_ready() const noexcept { return event.state.load(std::memory_order_acquire) == &event; }
+            bool await_suspend(std::coroutine_handle<> handle) noexcept {
+                void* expected = nullptr;
+                return event.state.compare_exchange_strong(expected, handle.address(), std::memory_order_acq_rel);  // false: set meanwhile
+            }
+            void await_resume() const noexcept {}
+        };
+        return Awaiter{*this};
+    }
+
+    void set() {
+        void* waiter = state.exchange(this, std::memory_order_acq_rel);
+        if (waiter)
+            std::coroutine_handle<>::from_address(waiter).resume();
+    }
+
+    void reset() { state.store(nullptr, std::memory_order_relaxed); }
+
+private:
+    std::atomic<void*> state{nullptr};
+};
+
+enum Stage { STEP, STATS, SNAPSHOT, EXPORT, NUM_STAGES };
+
+// Shared state of one pipelined run; generation g lives in grids[g % PIPELINE_DEPTH]
+struct Pipeline {
+    const Backend* backend;
+    FrameExporter& exporter;
+    SnapshotPublisher& snapshots;
+    int generations;
+    int export_every;
+    const TimingReport& report;
+
+    std::vector<Grid> grids;
+    StageEvent done[NUM_STAGES][PIPELINE_DEPTH];  // Stage finished the generation in the slot
+    long long kernel_us[PIPELINE_DEPTH] = {};     // Step time of the generation in the slot
+    std::atomic<bool> failed{false};              // The exporter failed, later steps are skipped
+    std::promise<void> finished;
+
+    // Statistics stage state
+    long long delta_t = 0;
+    int generation_count = 0;
+    int frame_count = 0;
+    std::chrono::high_resolution_clock::time_point report_start = std::chrono::high_resolution_clock::now();
+
+    Scheduler scheduler{NUM_STAGES};  // Declared last so its workers stop before anything else is destroyed
+
+    Pipeline(const Backend* backend, FrameExporter& exporter, SnapshotPublisher& snapshots, int generations, int export_every,
+             const TimingReport& report)
+        : backend(backend), exporter(exporter), snapshots(snapshots), generations(generations), export_every(export_every),
+          report(report) {}
+};
+
+/*
+Does one stage's work on one generation.
+
+Parameters:
+- p: Reference to the pipeline.
+- stage: Stage to run.
+- generation: Generation to work on.
+- slot: Grid holding the generation.
+
+Returns:
+- void
+*/
+void runStageWork(Pipeline& p, int stage, int generation, int slot) {
+    switch (stage) {
+        case STEP: {
+            if (p.failed.load(std::memory_order_relaxed))
+                break;
+            auto start = std::chrono::high_resolution_clock::now();
+            updateGrid(p.backend, p.grids[(generation - 1) % PIPELINE_DEPTH], p.grids[slot]);
+            auto end = std::chrono::high_resolution_clock::now();
+            p.kernel_us[slot] = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count();
+            break;
+        }
+        case STATS:
+            if (generation == 0)
+                break;
+            p.delta_t += p.kernel_us[slot];
+            if (generation % p.export_every == 0)
+                p.frame_count++;
+            if (++p.generation_count == 100) {
+                auto end = std::chrono::high_resolution_clock::now();
+                p.report(p.delta_t, std::chrono::duration<double>(end - p.report_start).count(), p.frame_count);
+                p.generation_count = 0;
+                p.delta_t = 0;
+                p.frame_count = 0;
+                p.report_start = end;
+            }
+            break;
+        case SNAPSHOT:
+            p.snapshots.publish(p.grids[slot], generation, generation % p.export_every == 0);
+            break;
+        case EXPORT:
+            if (generation % p.export_every == 0 && !p.failed.load(std::memory_order_relaxed)) {
+                p.exporter.submit(p.grids[slot], generation);
+                if (!p.exporter.ok())
+                    p.failed = true;
+            }
+            break;
+    }
+}
+
+/*
+Runs one stage over every generation in order. Each generation waits until
+the previous stage is done with it; stepping waits until the export stage
+has released the grid it is about to overwrite.
+*/
+Job runStage(Pipeline& p, int stage) {
+    int previous = stage == STEP ? EXPORT : stage - 1;
+    for (int generation = stage == STEP ? 1 : 0; generation <= p.generations; ++generation) {
+        int slot = generation % PIPELINE_DEPTH;
+        co_await p.done[previous][slot];
+        p.done[previous][slot].reset();
+        co_await p.scheduler.schedule();
+        runStageWork(p, stage, generation, slot);
+        if (stage == EXPORT && generation == p.generations) {
+            p.finished.set_value();
+            co_return;
+        }
+        p.done[stage][slot].set();
+    }
+}
+
+}  // namespace
+
+/*
+Exports the given number of generations like the serial headless loop, but
+with every stage running as its own coroutine. Stepping generation g
+overlaps with the statistics, snapshot and export of generations g - 1 to
+g - 3, and only the export stage may hold up stepping, once all grids are
+in flight.
+
+Parameters:
+- backend: Backend that computes the generations.
+- initial: Reference to the grid of generation 0.
+- exporter: Reference to the frame exporter.
+- snapshots: Reference to the snapshot publisher.
+- generations: Number of generations to compute.
+- export_every: Export every Nth generation.
+- report: Called with the timing of every 100 generations.
+
+Returns:
+- true if every frame was exported, false if the exporter failed.
+*/
+bool runPipelinedExport(const Backend* backend, const Grid& initial, FrameExporter& exporter, SnapshotPublisher& snapshots,
+                        int generations, int export_every, const TimingReport& report) {
+    Pipeline p(backend, exporter, snapshots, generations, export_every, report);
+    p.grids.assign(PIPELINE_DEPTH, initial);
+
+    // Generation 0 is ready for the statistics stage, and every other grid is free for stepping
+    p.done[STEP][0].set();
+    for (int slot = 1; slot < PIPELINE_DEPTH; ++slot)
+        p.done[EXPORT][slot].set();
+
+    std::future<void> finished = p.finished.get_future();
+    for (int stage = 0; stage < NUM_STAGES; ++stage)
+        runStage(p, stage);
+    finished.wait();
+    return !p.failed;
+}
+
+#endif
@@ -0,0 +1,37 @@
+/*
+Description:
+Frame pipelines for headless export. In the coroutine pipeline (C++20
+builds with LAB2_COROUTINES) the four stages of a generation, stepping,
+timing statistics, snapshot publishing and frame export, run as coroutines
+on a small scheduler. The flow graph (builds with TBB) connects update,
+statistics and render nodes of a tbb::flow::graph. Either way later stages
+of one generation overlap with stepping the next ones.
+*/
+
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "life.h"
+#include "export.h"
+#include "snapshot.h"
+#include <functional>
+
+// Receives the kernel time of the last 100 generations, the wall time they took and the frames exported meanwhile
+typedef std::function<void(long long delta_t, double wall_seconds, int frames)> TimingReport;
+
+#ifdef LAB2_COROUTINES
+// Grids in flight: one being stepped and up to three in the later stages
+const int PIPELINE_DEPTH = 4;
+
+// Runs the generations through the pipeline starting from the initial grid, false if the exporter failed
+bool runPipelinedExport(const Backend* backend, const Grid& initial, FrameExporter& exporter, SnapshotPublisher& snapshots,
+                        int generations, int export_every, const TimingReport& report);
+#endif
+
+#ifdef LAB2_TBB
+// Runs the generations through the TBB flow graph starting from the initial grid, false if the exporter failed
+bool runFlowGraphExport(const Backend* backend, const Grid& initial, FrameExporter& exporter, SnapshotPublisher& snapshots,
+                        int generations, int export_every, const TimingReport& report);
+#endif
+
+#endif
@@ -0,0 +1,283 @@
+/*
+Description:
+Viewport handling and texture or vertex based grid rendering.
+*/
+
+#include "render.h"
+#include "rules.h"
+#include <cstring>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// RGBA texel values in memory order (R, G, B, A bytes), independent of endianness
+static uint32_t makeTexel(uint8_t r, uint8_t g, uint8_t b) {
+    uint8_t bytes[4] = {r, g, b, 255};
+    uint32_t texel;
+    std::memcpy(&texel, bytes, sizeof(texel));
+    return texel;
+}
+
+/*
+Display color of a cell state: white when alive, black when dead and a
+fading blue for the dying states of Generations rules. Lenia levels are
+shown as gray.
+*/
+static sf::Color stateColor(uint8_t state) {
+    uint8_t shade = stateShade(state);
+    if (state <= 1 || RULE.continuous)
+        return sf::Color(shade, shade, shade);
+    return sf::Color(shade / 3, shade / 2, shade);
+}
+
+/*
+Zooms by a factor while keeping the cell under the given window pixel fixed.
+Zoom is limited so the coarsest density level still covers a window pixel.
+
+Parameters:
+- factor: Multiplier applied to the current zoom.
+- px, py: Window pixel the zoom is centered on.
+
+Returns:
+- void
+*/
+void Viewport::zoomAt(double factor, int px, int py) {
+    double cx = left + px / zoom, cy = top + py / zoom;  // Cell under the cursor
+    zoom = std::min(256.0, std::max(1.0 / (1 << DensityPyramid::MAX_LEVEL), zoom * factor));
+    left = cx - px / zoom;
+    top = cy - py / zoom;
+}
+
+/*
+Moves the view by a drag distance in window pixels.
+*/
+void Viewport::pan(int dx, int dy) {
+    left -= dx / zoom;
+    top -= dy / zoom;
+}
+
+sf::Vector2i Viewport::cellAt(int px, int py) const {
+    return sf::Vector2i(static_cast<int>(std::floor(left + px / zoom)), static_cast<int>(std::floor(top + py / zoom)));
+}
+
+VisibleBlocks visibleBlocks(const Viewport& view, const sf::Vector2u& window_size) {
+    VisibleBlocks visible;
+    visible.level = 0;
+    int block = 1;  // Cells per block side
+    while (view.zoom * block < 1 && visible.level < DensityPyramid::MAX_LEVEL) {
+        ++visible.level;
+        block *= 2;
+    }
+    visible.block_pixels = view.zoom * block;
+
+    int level_width = (GRID_WIDTH + block - 1) / block;
+    int level_height = (GRID_HEIGHT + block - 1) / block;
+    visible.x0 = std::max(0, static_cast<int>(std::floor(view.left / block)));
+    visible.y0 = std::max(0, static_cast<int>(std::floor(view.top / block)));
+    visible.x1 = std::min(level_width, static_cast<int>(std::ceil((view.left + window_size.x / view.zoom) / block)));
+    visible.y1 = std::min(level_height, static_cast<int>(std::ceil((view.top + window_size.y / view.zoom) / block)));
+    visible.x1 = std::max(visible.x0, visible.x1);
+    visible.y1 = std::max(visible.y0, visible.y1);
+    return visible;
+}
+
+/*
+Brings the density levels up to date for the visible blocks. Nothing is done
+when cells are drawn directly.
+*/
+static void refreshVisible(const VisibleBlocks& visible, const Grid& grid, DensityPyramid& density) {
+    if (visible.level == 0)
+        return;
+    int shift = visible.level;
+    density.refresh(grid, visible.x0 << shift, visible.y0 << shift, visible.x1 << shift, visible.y1 << shift);
+}
+
+/*
+Converts the visible cells or density blocks into texels, uploads them in one
+texture update and draws the positioned sprite. Rows are converted in
+parallel.
+
+Parameters:
+- window: Reference to the window to draw into.
+- grid: Reference to the grid to display.
+- view: Visible region and zoom.
+- density: Density summaries used when zoomed out.
+
+Returns:
+- void
+*/
+void TextureRenderer::draw(sf::RenderWindow& window, const Grid& grid, const Viewport& view, DensityPyramid& density) {
+    sf::Vector2u window_size = window.getSize();
+    VisibleBlocks visible = visibleBlocks(view, window_size);
+    int width = visible.x1 - visible.x0, height = visible.y1 - visible.y0;
+    if (width == 0 || height == 0)
+        return;  // Viewport is entirely outside the grid
+    refreshVisible(visible, grid, density);
+
+    // The texture only grows, sized to cover the window plus partially visible blocks
+    sf::Vector2u needed(std::max<unsigned>(window_size.x + 2, width), std::max<unsigned>(window_size.y + 2, height));
+    if (texture.getSize().x < needed.x || texture.getSize().y < needed.y) {
+        texture.create(needed.x, needed.y);
+        sprite.setTexture(texture, true);
+    }
+    pixels.resize(static_cast<size_t>(width) * height);
+
+    uint32_t palette[256];  // Texel for every cell state
+    for (int state = 0; state < 256; ++state) {
+        sf::Color color = stateColor(static_cast<uint8_t>(state));
+        palette[state] = makeTexel(color.r, color.g, color.b);
+    }
+
+    #pragma omp parallel for schedule(static) num_threads(NUM_THREADS)
+    for (int y = 0; y < height; ++y) {
+        uint32_t* row = &pixels[static_cast<size_t>(y) * width];
+        if (visible.level == 0) {
+            const uint8_t* cells = &grid[(visible.y0 + y + 1) * PITCH + 1 + visible.x0];
+            for (int x = 0; x < width; ++x)
+                row[x] = palette[cells[x]];
+        } else {
+            const uint8_t* blocks = density.row(visible.level, visible.y0 + y) + visible.x0;
+            for (int x = 0; x < width; ++x)
+                row[x] = makeTexel(blocks[x], blocks[x], blocks[x]);
+        }
+    }
+
+    texture.update(reinterpret_cast<const sf::Uint8*>(pixels.data()), width, height, 0, 0);
+    int block = 1 << visible.level;
+    sprite.setTextureRect(sf::IntRect(0, 0, width, height));
+    sprite.setScale(static_cast<float>(visible.block_pixels), static_cast<float>(visible.block_pixels));
+    sprite.setPosition(static_cast<float>((visible.x0 * block - view.left) * view.zoom),
+                       static_cast<float>((visible.y0 * block - view.top) * view.zoom));
+    window.draw(sprite);
+}
+
+/*
+Writes a quad for every visible live cell (or non-empty density block, shaded
+by its density) into the persistent band buffers and draws them. Buffers grow
+geometrically when a band needs more room than it did in any earlier frame
+and are never shrunk or rebuilt.
+
+Parameters:
+- window: Reference to the window to draw into.
+- grid: Reference to the grid to display.
+- view: Visible region and zoom.
+- density: Density summaries used when zoomed out.
+
+Returns:
+- void
+*/
+void VertexRenderer::draw(sf::RenderWindow& window, const Grid& grid, const Viewport& view, DensityPyramid& density) {
+    VisibleBlocks visible = visibleBlocks(view, window.getSize());
+    int height = visible.y1 - visible.y0;
+    if (visible.x1 == visible.x0 || height == 0)
+        return;  // Viewport is entirely outside the grid
+    refreshVisible(visible, grid, density);
+
+    int num_bands = std::max(1, std::min(NUM_THREADS, height));
+    if (static_cast<int>(bands.size()) != num_bands) {
+        bands.resize(num_bands);
+        used.resize(num_bands);
+    }
+    const int block = 1 << visible.level;
+    const float size = static_cast<float>(visible.block_pixels);
+    const double origin_x = -view.left * view.zoom, origin_y = -view.top * view.zoom;  // Window position of cell (0, 0)
+
+    #pragma omp parallel for schedule(static) num_threads(num_bands)
+    for (int band = 0; band < num_bands; ++band) {
+        std::vector<sf::Vertex>& vertices = bands[band];
+        size_t count = 0;
+        int y_begin = visible.y0 + static_cast<int>(static_cast<long long>(height) * band / num_bands);
+        int y_end = visible.y0 + static_cast<int>(static_cast<long long>(height) * (band + 1) / num_bands);
+        for (int y = y_begin; y < y_end; ++y) {
+            const uint8_t* values = visible.level ? density.row(visible.level, y) : &grid[(y + 1) * PITCH + 1];
+            float py = static_cast<float>(origin_y + static_cast<double>(y) * block * view.zoom);  // Calculate y position
+            for (int x = visible.x0; x < visible.x1; ++x) {
+                if (!values[x])
+                    continue;
+                if (count + 4 > vertices.size())
+                    vertices.resize(std::max<size_t>(256, vertices.size() * 2));  // Grow beyond the largest population seen
+                float px = static_cast<float>(origin_x + static_cast<double>(x) * block * view.zoom);  // Calculate x position
+                sf::Color color = visible.level ? sf::Color(values[x], values[x], values[x]) : stateColor(values[x]);
+                sf::Vertex* quad = &vertices[count];
+                quad[0] = sf::Vertex(sf::Vector2f(px, py), color);
+                quad[1] = sf::Vertex(sf::Vector2f(px + size, py), color);
+                quad[2] = sf::Vertex(sf::Vector2f(px + size, py + size), color);
+                quad[3] = sf::Vertex(sf::Vector2f(px, py + size), color);
+                count += 4;
+            }
+        }
+        used[band] = count;
+    }
+
+    for (int band = 0; band < num_bands; ++band) {
+        if (used[band])
+            window.draw(bands[band].data(), used[band], sf::Quads);
+    }
+}
+
+/*
+Parses a render policy specification.
+
+Parameters:
+- spec: fps:N, every:N or demand.
+
+Returns:
+- true if the specification was valid.
+*/
+bool RenderPolicy::parse(const std::string& spec) {
+    size_t colon = spec.find(':');
+    std::string name = spec.substr(0, colon);
+    int number = (colon == std::string::npos) ? 0 : std::atoi(spec.c_str() + colon + 1);
+    if (name == "fps" && number > 0)
+        mode = FPS;
+    else if (name == "every" && number > 0)
+        mode = EVERY;
+    else if (name == "demand" && colon == std::string::npos)
+        mode = DEMAND;
+    else
+        return false;
+    value = number;
+    return true;
+}
+
+/*
+Reports whether a frame should be drawn now. A requested redraw (input that
+changed the view) is always honored.
+
+Parameters:
+- generations_since_frame: Generations computed since the last frame.
+- seconds_since_frame: Wall time since the last frame.
+- requested: Whether input asked for a redraw.
+
+Returns:
+- true if a frame should be drawn.
+*/
+bool RenderPolicy::due(int generations_since_frame, double seconds_since_frame, bool requested) const {
+    if (requested)
+        return true;
+    switch (mode) {
+        case FPS:
+            return seconds_since_frame * value >= 1.0;
+        case EVERY:
+            return generations_since_frame >= value;
+        default:
+            return false;
+    }
+}
+
+/*
+Creates the renderer for a display mode.
+
+Parameters:
+- mode: Display mode name, TEX (texture) or VTX (vertex quads).
+
+Returns:
+- A new renderer owned by the caller, or nullptr if the mode is unknown.
+*/
+Renderer* createRenderer(const std::string& mode) {
+    if (mode == "TEX")
+        return new TextureRenderer();
+    if (mode == "VTX")
+        return new VertexRenderer();
+    return nullptr;
+}
@@ -0,0 +1,92 @@
+/*
+Description:
+Renders the visible part of the grid into the SFML window.
+*/
+
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <SFML/Graphics.hpp>
+#include <string>
+#include "life.h"
+#include "density.h"
+
+// Part of the grid shown in the window, changed by mouse-wheel zoom and drag-to-pan
+struct Viewport {
+    double left = 0, top = 0;  // Grid position (in cells) at the top-left corner of the window
+    double zoom = 1;           // Window pixels per cell
+
+    void zoomAt(double factor, int px, int py);
+    void pan(int dx, int dy);
+    sf::Vector2i cellAt(int px, int py) const;  // Cell under a window pixel (may be outside the grid)
+};
+
+// Region of one pyramid level covered by the window
+struct VisibleBlocks {
+    int level;            // 0 draws cells, higher levels draw 2^level x 2^level density blocks
+    int x0, y0, x1, y1;   // Visible block range [x0, x1) x [y0, y1) at that level
+    double block_pixels;  // Window pixels per block
+};
+
+/*
+Picks the coarsest-needed pyramid level so that one block covers at least one
+window pixel, and returns the blocks of that level inside the window.
+*/
+VisibleBlocks visibleBlocks(const Viewport& view, const sf::Vector2u& window_size);
+
+// Interface shared by the display modes selected with -d
+class Renderer {
+public:
+    virtual ~Renderer() {}
+    virtual void draw(sf::RenderWindow& window, const Grid& grid, const Viewport& view, DensityPyramid& density) = 0;
+};
+
+/*
+Draws the visible region as a single texture with one texel per cell (or per
+density block when zoomed out), positioned and scaled by a sprite. The pixel
+buffer and texture are sized to the window, so the cost of a frame does not
+depend on the size of the grid.
+*/
+class TextureRenderer : public Renderer {
+public:
+    void draw(sf::RenderWindow& window, const Grid& grid, const Viewport& view, DensityPyramid& density) override;
+
+private:
+    std::vector<uint32_t> pixels;  // RGBA texels for the visible blocks
+    sf::Texture texture;
+    sf::Sprite sprite;
+};
+
+/*
+Draws one quad per visible live cell (or non-empty density block). Each row
+band owns a vertex buffer that keeps its size from the previous frame, so
+buffers only grow when the population of a band exceeds anything seen before.
+Bands are filled in parallel and drawn with one call each.
+*/
+class VertexRenderer : public Renderer {
+public:
+    void draw(sf::RenderWindow& window, const Grid& grid, const Viewport& view, DensityPyramid& density) override;
+
+private:
+    std::vector<std::vector<sf::Vertex>> bands;  // Persistent vertex storage per row band
+    std::vector<size_t> used;                    // Vertices written to each band this frame
+};
+
+/*
+Decides when a frame is drawn, independently of how fast generations are
+computed. Specified with -R as fps:N (at most N frames per second), every:N
+(every Nth generation) or demand (only after input changes the view).
+*/
+struct RenderPolicy {
+    enum Mode { FPS, EVERY, DEMAND };
+    Mode mode = FPS;
+    int value = 60;
+
+    bool parse(const std::string& spec);
+    bool due(int generations_since_frame, double seconds_since_frame, bool requested) const;
+};
+
+// Creates the renderer for a display mode (TEX or VTX), nullptr if the name is unknown
+Renderer* createRenderer(const std::string& mode);
+
+#endif
@@ -0,0 +1,701 @@
+/*
+Description:
+Rule parsing, the Generations-family kernel, the neighborhood lookup kernel
+and the Larger than Life kernel.
+*/
+
+#include "rules.h"
+#include "lenia.h"
+#include "volume.h"
+#include "density.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+static void updateLife(const Backend* backend, Grid& grid_current, Grid& grid_next);
+static void updateGenerations(const Backend* backend, Grid& grid_current, Grid& grid_next);
+static void updatePatterns(const Backend* backend, Grid& grid_current, Grid& grid_next);
+static void updateLargerThanLife(const Backend* backend, Grid& grid_current, Grid& grid_next);
+
+/*
+Range 1 neighborhoods are 9-bit indices of the 3x3 block in reading order:
+bit 0 is the north-west neighbor, bit 4 the cell itself and bit 8 the
+south-east neighbor.
+*/
+static const int MOORE_MASK = 0x1EF;                        // All eight neighbors
+static const int HEX_MASK = MOORE_MASK & ~(0x004 | 0x040);  // Without the north-east and south-west corners
+static const int VON_NEUMANN_MASK = 0x0AA;                  // North, west, east and south
+
+// Hensel letters for each number of live neighbors up to four, and a
+// neighborhood of each letter's class in the same order. Counts above four
+// use the letters of 8 - count and the complements of their neighborhoods.
+static const char* const HENSEL_LETTERS[5] = {"", "ce", "ceaikn", "ceaiknjqry", "ceaiknjqrytwz"};
+static const int HENSEL_PATTERNS[5][13] = {
+    {},
+    {1, 2},
+    {5, 10, 3, 40, 33, 68},
+    {69, 42, 11, 7, 98, 13, 14, 70, 41, 97},
+    {325, 170, 15, 45, 99, 71, 106, 102, 43, 101, 105, 78, 108},
+};
+
+// Per-row live cell sums of the current generation, (GRID_HEIGHT + 2) rows of PITCH
+static std::vector<uint16_t> row_sums;
+
+Rule RULE = [] {
+    Rule rule;
+    rule.update = updateLife;
+    return rule;
+}();
+
+/*
+Computes the next state of a cell from the rule definition. Used to build the
+transition table and directly by the reference implementation in verify.cpp.
+
+Parameters:
+- rule: Rule to apply.
+- state: Current state of the cell.
+- live_neighbors: Number of neighbors in state 1.
+
+Returns:
+- The next state.
+*/
+int nextState(const Rule& rule, int state, int live_neighbors) {
+    if (state == 0)
+        return rule.birth[live_neighbors];
+    if (state == 1 && rule.survive[live_neighbors])
+        return 1;
+    return (state + 1 < rule.states) ? state + 1 : 0;  // Start or continue dying
+}
+
+/*
+Gray level used to display a cell state: live cells are white and dying
+cells fade out towards black.
+*/
+uint8_t stateShade(uint8_t state) {
+    if (RULE.continuous)
+        return state;  // Lenia levels map directly to gray
+    if (state <= 1)
+        return state ? 255 : 0;
+    return static_cast<uint8_t>(40 + 160 * (RULE.states - state) / RULE.states);
+}
+
+static int countBits(int bits) {
+    int count = 0;
+    for (; bits; bits &= bits - 1)
+        ++count;
+    return count;
+}
+
+// Applies one of the eight symmetries of the square (mirror, then 0-3 quarter turns) to a neighborhood
+static int transformPattern(int pattern, int symmetry) {
+    int result = 0;
+    for (int bit = 0; bit < 9; ++bit) {
+        if (!((pattern >> bit) & 1))
+            continue;
+        int row = bit / 3, col = bit % 3;
+        if (symmetry & 4)
+            col = 2 - col;
+        for (int turn = 0; turn < (symmetry & 3); ++turn) {
+            int old_row = row;
+            row = col;
+            col = 2 - old_row;
+        }
+        result |= 1 << (row * 3 + col);
+    }
+    return result;
+}
+
+// Checks whether a Moore neighborhood with the given number of live cells belongs to a Hensel letter's class
+static bool inHenselClass(int pattern, int count, char letter) {
+    int base = count <= 4 ? count : 8 - count;
+    int representative = HENSEL_PATTERNS[base][std::strchr(HENSEL_LETTERS[base], letter) - HENSEL_LETTERS[base]];
+    if (count > 4)
+        representative ^= MOORE_MASK;
+    for (int symmetry = 0; symmetry < 8; ++symmetry) {
+        if (transformPattern(representative, symmetry) == pattern)
+            return true;
+    }
+    return false;
+}
+
+/*
+Parses the birth or survival part of a range 1 rule: neighbor counts, each
+optionally followed by Hensel letters that keep only some arrangements of
+that many live neighbors (2a, 3-jn for all but j and n).
+
+Parameters:
+- text: Counts and letters.
+- mask: Neighborhood bits that are neighbors.
+- matches: Set to 512 flags, 1 for every neighborhood (cell bit clear) that matches.
+- canonical: Set to the counts in ascending order with the letters in Hensel order.
+- totalistic: Cleared if any letters were given.
+
+Returns:
+- true if the text was valid for the neighborhood.
+*/
+static bool parseNeighborhoods(const std::string& text, int mask, std::vector<uint8_t>& matches, std::string& canonical, bool& totalistic) {
+    matches.assign(512, 0);
+    std::string parts[9];  // Canonical text of each count
+    size_t i = 0;
+    while (i < text.size()) {
+        int count = text[i++] - '0';
+        if (count < 0 || count > countBits(mask) || !parts[count].empty())
+            return false;
+        bool negate = i < text.size() && text[i] == '-';
+        if (negate)
+            ++i;
+        std::string letters;
+        while (i < text.size() && std::islower(static_cast<unsigned char>(text[i])))
+            letters += text[i++];
+        if (negate && letters.empty())
+            return false;
+
+        parts[count] = std::to_string(count) + (negate ? "-" : "");
+        if (!letters.empty()) {
+            if (mask != MOORE_MASK || count == 0 || count == 8)
+                return false;
+            const char* valid = HENSEL_LETTERS[count <= 4 ? count : 8 - count];
+            for (char letter : letters) {
+                if (!std::strchr(valid, letter))
+                    return false;
+            }
+            for (const char* letter = valid; *letter; ++letter) {
+                if (letters.find(*letter) != std::string::npos)
+                    parts[count] += *letter;
+            }
+            totalistic = false;
+        }
+
+        for (int pattern = 0; pattern < 512; ++pattern) {
+            if ((pattern & ~mask) || countBits(pattern) != count)
+                continue;
+            bool listed = false;
+            for (char letter : letters)
+                listed = listed || inHenselClass(pattern, count, letter);
+            if (letters.empty() || listed != negate)
+                matches[pattern] = 1;
+        }
+    }
+    canonical.clear();
+    for (const std::string& part : parts)
+        canonical += part;
+    return true;
+}
+
+// Parses a non-negative decimal number of at most six digits
+static bool parseNumber(const std::string& digits, int& value) {
+    if (digits.empty() || digits.size() > 6 || digits.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    value = std::atoi(digits.c_str());
+    return true;
+}
+
+// Parses a neighbor count range "lo..hi" (or a single count) into per-count flags
+static bool parseRange(const std::string& text, int max_neighbors, std::vector<uint8_t>& counts, std::string& canonical) {
+    size_t dots = text.find("..");
+    int lo, hi;
+    if (!parseNumber(text.substr(0, dots), lo))
+        return false;
+    if (dots == std::string::npos)
+        hi = lo;
+    else if (!parseNumber(text.substr(dots + 2), hi))
+        return false;
+    counts.assign(max_neighbors + 1, 0);
+    for (int n = lo; n <= std::min(hi, max_neighbors); ++n)
+        counts[n] = 1;
+    canonical = std::to_string(lo) + ".." + std::to_string(hi);
+    return true;
+}
+
+/*
+Fills in the transition table and picks the kernel for a parsed rule.
+*/
+static void compileRule(Rule& rule) {
+    int stride = rule.max_neighbors + 1;
+    rule.table.assign(256 * stride, 0);
+    for (int state = 0; state < rule.states; ++state) {
+        for (int n = 0; n <= rule.max_neighbors; ++n)
+            rule.table[state * stride + n] = static_cast<uint8_t>(nextState(rule, state, n));
+    }
+
+    // The hand-written B3/S23 kernel is used whenever it applies
+    const Rule life;
+    bool moore1 = rule.range == 1 && rule.neighborhood == 'M' && !rule.middle;
+    bool is_life = moore1 && rule.states == 2 && rule.birth == life.birth && rule.survive == life.survive;
+    if (!rule.patterns.empty())
+        rule.update = updatePatterns;
+    else
+        rule.update = is_life ? updateLife : moore1 ? updateGenerations : updateLargerThanLife;
+}
+
+/*
+Parses a Larger than Life rule such as R5,C0,M1,S34..58,B34..45,NM (Bosco's
+rule). R is the range, C the number of states (0 and 2 both mean two), M
+whether the cell counts itself, S and B the survival and birth ranges of the
+live neighbor count and N the neighborhood (M for Moore, N for von Neumann).
+*/
+static bool parseLargerThanLife(const std::string& spec, Rule& rule) {
+    std::vector<std::string> fields(1);
+    for (char c : spec) {
+        if (c == ',')
+            fields.push_back("");
+        else
+            fields.back() += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    }
+
+    Rule parsed;
+    std::string birth, survive;
+    for (const std::string& field : fields) {
+        if (field.empty())
+            return false;
+        std::string value = field.substr(1);
+        int number = 0;
+        switch (field[0]) {
+            case 'R':
+                if (!parseNumber(value, parsed.range) || parsed.range < 1 || parsed.range > MAX_RANGE)
+                    return false;
+                break;
+            case 'C':
+                if (!parseNumber(value, number) || number == 1 || number > 255)
+                    return false;
+                parsed.states = std::max(2, number);
+                break;
+            case 'M':
+                if (value != "0" && value != "1")
+                    return false;
+                parsed.middle = value == "1";
+                break;
+            case 'N':
+                if (value != "M" && value != "N")
+                    return false;
+                parsed.neighborhood = value[0];
+                break;
+            case 'S':
+                survive = value;
+                break;
+            case 'B':
+                birth = value;
+                break;
+            default:
+                return false;
+        }
+    }
+
+    int side = 2 * parsed.range + 1;
+    parsed.max_neighbors = parsed.neighborhood == 'M' ? side * side : 2 * parsed.range * (parsed.range + 1) + 1;
+    if (!parsed.middle)
+        parsed.max_neighbors -= 1;
+    std::string birth_range, survive_range;
+    if (!parseRange(birth, parsed.max_neighbors, parsed.birth, birth_range)
+        || !parseRange(survive, parsed.max_neighbors, parsed.survive, survive_range))
+        return false;
+    if (parsed.birth[0])
+        return false;  // B0 would turn the unbounded dead region alive
+
+    parsed.name = "R" + std::to_string(parsed.range) + ",C" + std::to_string(parsed.states) + ",M" + (parsed.middle ? "1" : "0")
+                + ",S" + survive_range + ",B" + birth_range + ",N" + parsed.neighborhood;
+    compileRule(parsed);
+    rule = parsed;
+    return true;
+}
+
+/*
+Parses a rule string. Accepted forms:
+- B/S notation: B3/S23 (Life), B2/S/C3 or B2/S/3 (Brian's Brain).
+- S/B/C notation: 23/3 (Life), /2/3 (Brian's Brain), 345/2/4 (Star Wars).
+- Hensel notation: B2-a/S12 (isotropic non-totalistic counts).
+- An H or V suffix for the hexagonal or von Neumann neighborhood: B2/S34H.
+- Larger than Life: R5,C0,M1,S34..58,B34..45,NM (Bosco's rule).
+- Lenia: LENIA or LENIA,R13,T10,M0.15,S0.015 (see lenia.cpp).
+- 3D: 3D4555 or 3D4555/BYTE (see volume.cpp).
+
+Parameters:
+- spec: Rule string.
+- rule: Rule to fill in.
+
+Returns:
+- true if the string was a valid rule.
+*/
+bool parseRule(const std::string& spec, Rule& rule) {
+    if (spec.size() > 1 && (spec[0] == 'R' || spec[0] == 'r') && std::isdigit(static_cast<unsigned char>(spec[1])))
+        return parseLargerThanLife(spec, rule);
+    if (spec.size() >= 5 && std::toupper(static_cast<unsigned char>(spec[0])) == 'L')
+        return parseLenia(spec, rule);
+    if (spec.size() > 2 && spec[0] == '3' && std::toupper(static_cast<unsigned char>(spec[1])) == 'D')
+        return parseVolumeRule(spec, rule);  // Other specs starting with 3 are S/B rules such as 34/34
+
+    Rule parsed;
+    int mask = MOORE_MASK;
+    std::string body = spec, suffix;
+    if (!body.empty() && (body.back() == 'H' || body.back() == 'V')) {
+        suffix = body.substr(body.size() - 1);
+        parsed.neighborhood = suffix == "H" ? 'H' : 'N';
+        mask = suffix == "H" ? HEX_MASK : VON_NEUMANN_MASK;
+        body.pop_back();
+    }
+
+    std::vector<std::string> fields(1);
+    for (char c : body) {
+        if (c == '/')
+            fields.push_back("");
+        else
+            fields.back() += c;
+    }
+    if (fields.size() < 2 || fields.size() > 3)
+        return false;
+
+    std::string birth, survive, states = "2";
+    if (!fields[0].empty() && std::toupper(static_cast<unsigned char>(fields[0][0])) == 'B') {
+        if (fields[1].empty() || std::toupper(static_cast<unsigned char>(fields[1][0])) != 'S')
+            return false;
+        birth = fields[0].substr(1);
+        survive = fields[1].substr(1);
+        if (fields.size() == 3) {
+            char prefix = fields[2].empty() ? 0 : static_cast<char>(std::toupper(static_cast<unsigned char>(fields[2][0])));
+            states = (prefix == 'C' || prefix == 'G') ? fields[2].substr(1) : fields[2];
+        }
+    } else {
+        survive = fields[0];
+        birth = fields[1];
+        if (fields.size() == 3)
+            states = fields[2];
+    }
+    std::vector<uint8_t> birth_set, survive_set;
+    std::string birth_text, survive_text;
+    bool totalistic = true;
+    if (!parseNeighborhoods(birth, mask, birth_set, birth_text, totalistic)
+        || !parseNeighborhoods(survive, mask, survive_set, survive_text, totalistic))
+        return false;
+    if (!parseNumber(states, parsed.states) || parsed.states < 2 || parsed.states > 255)
+        return false;
+    if (birth_set[0])
+        return false;  // B0 would turn the unbounded dead region alive
+
+    parsed.max_neighbors = countBits(mask);
+    parsed.birth.assign(parsed.max_neighbors + 1, 0);
+    parsed.survive.assign(parsed.max_neighbors + 1, 0);
+    if (totalistic) {
+        for (int pattern = 0; pattern < 512; ++pattern) {
+            parsed.birth[countBits(pattern)] |= birth_set[pattern];
+            parsed.survive[countBits(pattern)] |= survive_set[pattern];
+        }
+    }
+    if (!totalistic || mask != MOORE_MASK) {
+        // Cells outside the mask are ignored, the cell bit selects birth or survival
+        parsed.patterns.assign(512, 0);
+        for (int index = 0; index < 512; ++index) {
+            int neighbors = index & mask;
+            if (index & 0x010)
+                parsed.patterns[index] = survive_set[neighbors] ? 1 : (parsed.states > 2 ? 2 : 0);
+            else
+                parsed.patterns[index] = birth_set[neighbors];
+        }
+    }
+
+    parsed.name = "B" + birth_text + "/S" + survive_text;
+    if (parsed.states > 2)
+        parsed.name += "/C" + std::to_string(parsed.states);
+    parsed.name += suffix;
+    compileRule(parsed);
+    rule = parsed;
+    return true;
+}
+
+/*
+Updates the grid with the standard B3/S23 kernel, in 2D tiles on backends
+that split rectangles.
+*/
+static void updateLife(const Backend* backend, Grid& grid_current, Grid& grid_next) {
+    if (backend->run_tiles) {
+        backend->run_tiles(1, GRID_HEIGHT + 1, 1, GRID_WIDTH + 1, [&](int y_begin, int y_end, int x_begin, int x_end) {
+            updateTileLife(grid_current, grid_next, y_begin, y_end, x_begin, x_end);
+            reportChangedCells(grid_current, grid_next, y_begin, y_end, x_begin, x_end);
+        });
+        return;
+    }
+    backend->run_rows(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) {
+        updateRowsLife(grid_current, grid_next, y_begin, y_end);
+        reportChangedCells(grid_current, grid_next, y_begin, y_end);
+    });
+}
+
+/*
+Applies the active Generations rule to a range of rows.
+Each row is done in two passes so the counting pass has no table lookups and
+vectorizes: first the live cells of every column of three rows are summed,
+then each cell adds the column sums of its left and right neighbors and looks
+its next state up in the transition table.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y_begin: First padded row to compute.
+- y_end: Padded row after the last one to compute.
+
+Returns:
+- void
+*/
+static void updateRowsGenerations(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end) {
+    const uint8_t* table = RULE.table.data();
+    const int stride = RULE.max_neighbors + 1;
+    std::vector<uint8_t> column(PITCH);  // Live cells in each padded column of the three rows
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint8_t* up = &grid_current[(y - 1) * PITCH];
+        const uint8_t* mid = up + PITCH;
+        const uint8_t* down = mid + PITCH;
+        uint8_t* out = &grid_next[y * PITCH];
+        uint8_t* sums = column.data();
+        #pragma omp simd
+        for (int x = 0; x < PITCH; ++x)
+            sums[x] = (up[x] == 1) + (mid[x] == 1) + (down[x] == 1);
+        #pragma omp simd
+        for (int x = 1; x <= GRID_WIDTH; ++x) {
+            int neighbors = sums[x - 1] + sums[x] + sums[x + 1] - (mid[x] == 1);
+            out[x] = table[mid[x] * stride + neighbors];
+        }
+    }
+}
+
+/*
+Updates the grid with the table-driven Generations kernel.
+*/
+static void updateGenerations(const Backend* backend, Grid& grid_current, Grid& grid_next) {
+    backend->run_rows(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) {
+        updateRowsGenerations(grid_current, grid_next, y_begin, y_end);
+        reportChangedCells(grid_current, grid_next, y_begin, y_end);
+    });
+}
+
+/*
+Applies the active neighborhood lookup rule to a range of rows.
+The live cells of each column of three rows are first packed into a 3-bit
+code spread over bits 0, 3 and 6. Walking along the row, the 9-bit index
+shifts the two columns it keeps one place left and adds the next column's
+code, so each cell costs one shift, one mask and one or and a single lookup
+in the 512-entry table. Dying cells of Generations rules advance through
+the transition table instead.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y_begin: First padded row to compute.
+- y_end: Padded row after the last one to compute.
+
+Returns:
+- void
+*/
+static void updateRowsPatterns(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end) {
+    const uint8_t* patterns = RULE.patterns.data();
+    const uint8_t* table = RULE.table.data();
+    const int stride = RULE.max_neighbors + 1;
+    std::vector<uint16_t> column(PITCH);  // Live cells of each padded column of the three rows
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint8_t* up = &grid_current[(y - 1) * PITCH];
+        const uint8_t* mid = up + PITCH;
+        const uint8_t* down = mid + PITCH;
+        uint8_t* out = &grid_next[y * PITCH];
+        uint16_t* codes = column.data();
+        #pragma omp simd
+        for (int x = 0; x < PITCH; ++x)
+            codes[x] = (up[x] == 1) | (mid[x] == 1) << 3 | (down[x] == 1) << 6;
+
+        int index = codes[0] << 1 | codes[1] << 2;
+        for (int x = 1; x <= GRID_WIDTH; ++x) {
+            index = ((index >> 1) & 0x0DB) | codes[x + 1] << 2;  // Drop the column that left, add the one that entered
+            out[x] = (mid[x] > 1) ? table[mid[x] * stride] : patterns[index];
+        }
+    }
+}
+
+/*
+Updates the grid with the neighborhood lookup kernel.
+*/
+static void updatePatterns(const Backend* backend, Grid& grid_current, Grid& grid_next) {
+    backend->run_rows(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) {
+        updateRowsPatterns(grid_current, grid_next, y_begin, y_end);
+        reportChangedCells(grid_current, grid_next, y_begin, y_end);
+    });
+}
+
+/*
+Tells whether the rule's kernel computes a generation in a single
+row-parallel stage that reads only the row above and below each row, so
+any band of rows can be computed as soon as its neighbors are. The
+multi-generation task backend pipelines only these rules.
+
+Parameters:
+- rule: Rule to check.
+
+Returns:
+- true for the B3/S23, Generations and neighborhood lookup kernels.
+*/
+bool isRowLocalRule(const Rule& rule) {
+    return rule.update == updateLife || rule.update == updateGenerations || rule.update == updatePatterns;
+}
+
+/*
+Tells whether the rule is a two-state totalistic rule on the range 1 Moore
+neighborhood, whose next state only depends on the cell and its number of
+live neighbors (0 to 8), so it can be computed on bit-packed words.
+
+Parameters:
+- rule: Rule to check.
+
+Returns:
+- true for B3/S23 and every other two-state B/S rule without Hensel letters.
+*/
+bool isLifeLikeRule(const Rule& rule) {
+    return rule.update == updateLife || (rule.update == updateGenerations && rule.states == 2);
+}
+
+/*
+Computes the live cell sums of a range of rows for the Larger than Life
+kernel. Von Neumann rules store the prefix sum of each row (entry x counts
+the live cells in columns 1..x), Moore rules the sum over the window of
+2R+1 columns centred on each cell. Columns outside the grid count as dead.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- y_begin: First padded row to sum.
+- y_end: Padded row after the last one to sum.
+
+Returns:
+- void
+*/
+static void sumRowsLargerThanLife(const Grid& grid_current, int y_begin, int y_end) {
+    const int range = RULE.range;
+    const bool moore = RULE.neighborhood == 'M';
+    std::vector<uint16_t> prefix(PITCH);
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint8_t* row = &grid_current[y * PITCH];
+        uint16_t* sums = &row_sums[static_cast<size_t>(y) * PITCH];
+        uint16_t* p = moore ? prefix.data() : sums;
+        p[0] = 0;
+        for (int x = 1; x <= GRID_WIDTH; ++x)
+            p[x] = p[x - 1] + (row[x] == 1);
+        if (moore) {
+            #pragma omp simd
+            for (int x = 1; x <= GRID_WIDTH; ++x)
+                sums[x] = p[std::min(GRID_WIDTH, x + range)] - p[std::max(0, x - range - 1)];
+        }
+    }
+}
+
+/*
+Applies a Larger than Life rule with a Moore neighborhood to a range of rows.
+The window sums of the 2R+1 rows around the current row are kept per column
+and slide down one row at a time, so every cell costs a constant number of
+operations whatever the range. Each call sums the window of its first row
+from scratch, which lets row bands run independently.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y_begin: First padded row to compute.
+- y_end: Padded row after the last one to compute.
+
+Returns:
+- void
+*/
+static void updateRowsBox(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end) {
+    const int range = RULE.range, stride = RULE.max_neighbors + 1;
+    const int exclude_self = RULE.middle ? 0 : 1;
+    const uint8_t* table = RULE.table.data();
+    const uint16_t* sums = row_sums.data();
+
+    std::vector<uint16_t> window(PITCH, 0);  // Live cells in each column of the 2R+1 row window
+    uint16_t* column = window.data();
+    for (int y = std::max(1, y_begin - range); y <= std::min(GRID_HEIGHT, y_begin + range); ++y) {
+        const uint16_t* row = sums + static_cast<size_t>(y) * PITCH;
+        #pragma omp simd
+        for (int x = 1; x <= GRID_WIDTH; ++x)
+            column[x] += row[x];
+    }
+
+    for (int y = y_begin; y < y_end; ++y) {
+        const uint8_t* mid = &grid_current[y * PITCH];
+        uint8_t* out = &grid_next[y * PITCH];
+        #pragma omp simd
+        for (int x = 1; x <= GRID_WIDTH; ++x) {
+            int neighbors = column[x] - exclude_self * (mid[x] == 1);
+            out[x] = table[mid[x] * stride + neighbors];
+        }
+
+        // Slide the window down one row
+        if (y + range + 1 <= GRID_HEIGHT) {
+            const uint16_t* entering = sums + static_cast<size_t>(y + range + 1) * PITCH;
+            #pragma omp simd
+            for (int x = 1; x <= GRID_WIDTH; ++x)
+                column[x] += entering[x];
+        }
+        if (y - range >= 1) {
+            const uint16_t* leaving = sums + static_cast<size_t>(y - range) * PITCH;
+            #pragma omp simd
+            for (int x = 1; x <= GRID_WIDTH; ++x)
+                column[x] -= leaving[x];
+        }
+    }
+}
+
+/*
+Applies a Larger than Life rule with a von Neumann neighborhood to a range
+of rows. Each of the 2R+1 rows of the diamond contributes one span of cells,
+read as the difference of two entries of its prefix sum, so a cell costs
+2(2R+1) loads instead of one per neighbor.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+- y_begin: First padded row to compute.
+- y_end: Padded row after the last one to compute.
+
+Returns:
+- void
+*/
+static void updateRowsDiamond(const Grid& grid_current, Grid& grid_next, int y_begin, int y_end) {
+    const int range = RULE.range, stride = RULE.max_neighbors + 1;
+    const int exclude_self = RULE.middle ? 0 : 1;
+    const uint8_t* table = RULE.table.data();
+
+    std::vector<uint16_t> counts(PITCH);  // Live cells in the diamond of each cell of the row
+    for (int y = y_begin; y < y_end; ++y) {
+        std::fill(counts.begin(), counts.end(), 0);
+        for (int dy = -range; dy <= range; ++dy) {
+            if (y + dy < 1 || y + dy > GRID_HEIGHT)
+                continue;
+            const uint16_t* prefix = &row_sums[static_cast<size_t>(y + dy) * PITCH];
+            int half = range - (dy < 0 ? -dy : dy);  // Half width of the span in this row
+            #pragma omp simd
+            for (int x = 1; x <= GRID_WIDTH; ++x)
+                counts[x] += prefix[std::min(GRID_WIDTH, x + half)] - prefix[std::max(0, x - half - 1)];
+        }
+
+        const uint8_t* mid = &grid_current[y * PITCH];
+        uint8_t* out = &grid_next[y * PITCH];
+        #pragma omp simd
+        for (int x = 1; x <= GRID_WIDTH; ++x) {
+            int neighbors = counts[x] - exclude_self * (mid[x] == 1);
+            out[x] = table[mid[x] * stride + neighbors];
+        }
+    }
+}
+
+/*
+Updates the grid with the Larger than Life kernel in two row-parallel
+stages: the per-row sums of every row, then the neighborhood counts and
+next states.
+*/
+static void updateLargerThanLife(const Backend* backend, Grid& grid_current, Grid& grid_next) {
+    row_sums.resize(static_cast<size_t>(GRID_HEIGHT + 2) * PITCH);
+    backend->run_rows(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) {
+        sumRowsLargerThanLife(grid_current, y_begin, y_end);
+    });
+    backend->run_rows(1, GRID_HEIGHT + 1, [&](int y_begin, int y_end) {
+        if (RULE.neighborhood == 'M')
+            updateRowsBox(grid_current, grid_next, y_begin, y_end);
+        else
+            updateRowsDiamond(grid_current, grid_next, y_begin, y_end);
+        reportChangedCells(grid_current, grid_next, y_begin, y_end);
+    });
+}
@@ -0,0 +1,65 @@
+/*
+Description:
+Cellular automaton rules selected with -r and the kernels that implement them.
+*/
+
+#ifndef RULES_H
+#define RULES_H
+
+#include "life.h"
+#include <string>
+#include <vector>
+
+/*
+Generations-family rule. Cells are 0 (dead), 1 (alive) or 2..states-1
+(dying). A dead cell is born when its number of live neighbors is in the
+birth set, a live cell survives when it is in the survival set and otherwise
+starts dying, and dying cells advance one state per generation until they
+reach 0. Only live (state 1) cells count as neighbors. With two states this
+is an ordinary Life-like B/S rule.
+Larger than Life rules extend the neighborhood to every cell within a range
+R, either a (2R+1)x(2R+1) square (Moore) or a diamond (von Neumann), and may
+count the cell itself.
+Isotropic non-totalistic (Hensel notation), hexagonal and range 1 von
+Neumann rules decide on the exact arrangement of the live neighbors instead
+of their number, through a table indexed by the 9-bit neighborhood.
+Continuous rules (Lenia) treat the cell value as a level from 0 to 255 and
+only use the name, range and growth parameters. Volume rules count the 26
+neighbors of a cell in a 3D grid.
+*/
+struct Rule {
+    std::string name = "B3/S23";      // Canonical rule string
+    int states = 2;                   // Number of cell states
+    int range = 1;                    // Neighborhood radius R
+    char neighborhood = 'M';          // 'M' for Moore (square), 'N' for von Neumann (diamond), 'H' for hexagonal
+    bool middle = false;              // The cell counts as one of its own neighbors
+    int max_neighbors = 8;            // Size of the neighborhood
+    std::vector<uint8_t> birth = {0, 0, 0, 1, 0, 0, 0, 0, 0};    // Indexed by live neighbors: 1 if a dead cell is born
+    std::vector<uint8_t> survive = {0, 0, 1, 1, 0, 0, 0, 0, 0};  // Indexed by live neighbors: 1 if a live cell survives
+    std::vector<uint8_t> table;       // Next state indexed by state * (max_neighbors + 1) + live neighbors
+    std::vector<uint8_t> patterns;    // Next state of dead and live cells indexed by neighborhood bits, empty for totalistic Moore rules
+    bool continuous = false;          // Cells hold levels (Lenia) rather than discrete states
+    double growth_center = 0.15;      // Lenia: neighborhood sum with the largest growth (mu)
+    double growth_width = 0.015;      // Lenia: width of the growth function (sigma)
+    int time_steps = 10;              // Lenia: generations per unit of time (T)
+    bool volume = false;              // 3D rule on the voxel grid
+    bool packed = false;              // 3D: use the bit-packed kernel
+
+    // Computes one generation using the backend's threading
+    void (*update)(const Backend* backend, Grid& grid_current, Grid& grid_next) = nullptr;
+};
+
+// Largest Larger than Life range accepted by parseRule
+const int MAX_RANGE = 50;
+
+// Active rule (B3/S23 unless -r is given)
+extern Rule RULE;
+
+// Function Prototypes
+bool parseRule(const std::string& spec, Rule& rule);
+int nextState(const Rule& rule, int state, int live_neighbors);
+bool isRowLocalRule(const Rule& rule);
+bool isLifeLikeRule(const Rule& rule);
+uint8_t stateShade(uint8_t state);
+
+#endif
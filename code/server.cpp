@@ -0,0 +1,399 @@
+/*
+Description:
+HTTP status and control server on a poll() event loop.
+*/
+
+#include "server.h"
+#include "topology.h"
+#include "rules.h"
+#include "stats.h"
+#include "export.h"
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+static const size_t MAX_REQUEST_BYTES = 8192;     // Longer headers are refused
+static const size_t MAX_CONNECTIONS = 64;         // Further clients wait in the listen backlog
+static const int IDLE_TIMEOUT_SECONDS = 10;       // Connections that send nothing are closed
+static const long long MAX_VIEWPORT_PIXELS = 4096LL * 4096;
+static const int MAX_VIEWPORT_SCALE = 64;         // Pixels per cell side in /viewport.png
+
+/*
+Builds a complete HTTP/1.1 response. Every response closes the connection,
+which keeps the event loop free of keep-alive bookkeeping.
+*/
+static std::string httpResponse(int status, const char* reason, const char* type, const std::string& body) {
+    std::ostringstream out;
+    out << "HTTP/1.1 " << status << " " << reason << "\r\n"
+        << "Content-Type: " << type << "\r\n"
+        << "Content-Length: " << body.size() << "\r\n"
+        << "Cache-Control: no-store\r\n"
+        << "Connection: close\r\n\r\n"
+        << body;
+    return out.str();
+}
+
+static std::string jsonError(int status, const char* reason, const std::string& message) {
+    return httpResponse(status, reason, "application/json", "{\"error\":\"" + message + "\"}\n");
+}
+
+/*
+Finds an integer parameter in a query string such as "x=10&y=20".
+
+Parameters:
+- query: Query string without the leading '?'.
+- key: Parameter name.
+- value: Reference receiving the value if the parameter is present.
+
+Returns:
+- true if the parameter is present and numeric, false otherwise.
+*/
+static bool queryInt(const std::string& query, const char* key, int& value) {
+    std::string prefix = std::string(key) + "=";
+    size_t start = 0;
+    while (start <= query.size()) {
+        size_t end = query.find('&', start);
+        if (end == std::string::npos)
+            end = query.size();
+        if (query.compare(start, prefix.size(), prefix) == 0) {
+            std::string text = query.substr(start + prefix.size(), end - start - prefix.size());
+            char* stop = nullptr;
+            long parsed = std::strtol(text.c_str(), &stop, 10);
+            if (text.empty() || *stop != '\0')
+                return false;
+            value = static_cast<int>(parsed);
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+static std::string jsonString(const std::string& text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out + "\"";
+}
+
+StatusServer::StatusServer(int port, SnapshotBuffer& source, const std::string& backend_name, int threads)
+    : source(source), backend_name(backend_name), threads(std::max(1, std::min(threads, MAX_TIMED_THREADS))) {
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    sockaddr_in address;
+    std::memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);  // Never reachable from other machines
+    if (listen_fd < 0 || setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(listen_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listen_fd, 16) != 0 ||
+        fcntl(listen_fd, F_SETFL, O_NONBLOCK) != 0 || pipe(wake_pipe) != 0) {
+        std::cerr << "Cannot listen on 127.0.0.1:" << port << ": " << std::strerror(errno) << std::endl;
+        if (listen_fd >= 0)
+            close(listen_fd);
+        listen_fd = -1;
+        return;
+    }
+    last_sample = std::chrono::steady_clock::now();
+    sampled_busy_ns.assign(this->threads, 0);
+    busy_ms_per_sec.assign(this->threads, 0);
+    for (int i = 0; i < this->threads; ++i)
+        sampled_busy_ns[i] = THREAD_BUSY_NS[i].load(std::memory_order_relaxed);
+    thread = std::thread(&StatusServer::run, this);
+}
+
+StatusServer::~StatusServer() {
+    stopping = true;
+    if (thread.joinable()) {
+        char byte = 0;
+        if (write(wake_pipe[1], &byte, 1) < 0)
+            std::cerr << "Cannot wake the status server: " << std::strerror(errno) << std::endl;
+        thread.join();
+    }
+    if (listen_fd >= 0)
+        close(listen_fd);
+    for (int fd : wake_pipe)
+        if (fd >= 0)
+            close(fd);
+}
+
+/*
+Event loop: waits for the listening socket, the connections and the wake
+pipe at once and handles whatever is ready, sampling the rates in between.
+Nothing in the loop waits on the simulation.
+*/
+void StatusServer::run() {
+    std::vector<Connection> connections;
+    std::vector<pollfd> fds;
+    while (!stopping) {
+        fds.clear();
+        fds.push_back({wake_pipe[0], POLLIN, 0});
+        fds.push_back({listen_fd, static_cast<short>(connections.size() < MAX_CONNECTIONS ? POLLIN : 0), 0});
+        for (const Connection& connection : connections)
+            fds.push_back({connection.fd, static_cast<short>(connection.response.empty() ? POLLIN : POLLOUT), 0});
+        if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR)
+            break;
+
+        auto now = std::chrono::steady_clock::now();
+        if (now - last_sample >= std::chrono::milliseconds(500))
+            sample();
+
+        // Service existing connections first; fds[i + 2] belongs to connections[i]
+        size_t kept = 0;
+        for (size_t i = 0; i < connections.size(); ++i) {
+            bool open = serviceConnection(connections[i], fds[i + 2].revents) &&
+                        now - connections[i].opened < std::chrono::seconds(IDLE_TIMEOUT_SECONDS);
+            if (open)
+                connections[kept++] = std::move(connections[i]);
+            else
+                close(connections[i].fd);
+        }
+        connections.resize(kept);
+
+        if (fds[1].revents & POLLIN)
+            acceptConnections(connections);
+    }
+    for (const Connection& connection : connections)
+        close(connection.fd);
+}
+
+/*
+Moves to the newest snapshot and turns the generation and busy time deltas
+since the last sample into rates.
+*/
+void StatusServer::sample() {
+    auto now = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(now - last_sample).count();
+    source.acquire();
+    long long generation = source.current().generation;
+    if (sampled_generation >= 0 && seconds > 0)
+        gens_per_sec = (generation - sampled_generation) / seconds;
+    sampled_generation = generation;
+    for (int i = 0; i < threads; ++i) {
+        long long busy = THREAD_BUSY_NS[i].load(std::memory_order_relaxed);
+        busy_ms_per_sec[i] = seconds > 0 ? (busy - sampled_busy_ns[i]) / 1e6 / seconds : 0;
+        sampled_busy_ns[i] = busy;
+    }
+    last_sample = now;
+}
+
+void StatusServer::acceptConnections(std::vector<Connection>& connections) {
+    while (connections.size() < MAX_CONNECTIONS) {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0)
+            return;  // EAGAIN once the backlog is empty
+        fcntl(fd, F_SETFL, O_NONBLOCK);
+        Connection connection;
+        connection.fd = fd;
+        connection.opened = std::chrono::steady_clock::now();
+        connections.push_back(std::move(connection));
+    }
+}
+
+/*
+Reads the request header until it is complete, answers it and sends the
+response as far as the socket accepts it.
+
+Parameters:
+- connection: Reference to the connection to service.
+- events: Events poll() reported for its socket.
+
+Returns:
+- true while the connection stays open, false once it is done or broken.
+*/
+bool StatusServer::serviceConnection(Connection& connection, short events) {
+    if (events & (POLLERR | POLLNVAL))
+        return false;
+    if (connection.response.empty() && (events & (POLLIN | POLLHUP))) {
+        char buffer[2048];
+        ssize_t received = recv(connection.fd, buffer, sizeof(buffer), 0);
+        if (received <= 0)
+            return received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+        connection.request.append(buffer, received);
+        if (connection.request.find("\r\n\r\n") == std::string::npos) {
+            if (connection.request.size() <= MAX_REQUEST_BYTES)
+                return true;
+            connection.response = jsonError(431, "Request Header Fields Too Large", "request header too large");
+        } else {
+            // Request line: METHOD PATH[?QUERY] VERSION
+            std::istringstream line(connection.request.substr(0, connection.request.find("\r\n")));
+            std::string method, target;
+            line >> method >> target;
+            size_t mark = target.find('?');
+            std::string path = target.substr(0, mark);
+            std::string query = mark == std::string::npos ? "" : target.substr(mark + 1);
+            connection.response = handle(method, path, query);
+        }
+    }
+    if (!connection.response.empty()) {
+        ssize_t sent = send(connection.fd, connection.response.data() + connection.sent,
+                            connection.response.size() - connection.sent, MSG_NOSIGNAL);
+        if (sent < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        connection.sent += sent;
+        return connection.sent < connection.response.size();
+    }
+    return true;
+}
+
+/*
+Routes a request to its endpoint. Reads use GET, anything that changes the
+run uses POST.
+*/
+std::string StatusServer::handle(const std::string& method, const std::string& path, const std::string& query) {
+    bool get = method == "GET", post = method == "POST";
+    if (path == "/") {
+        if (!get)
+            return jsonError(405, "Method Not Allowed", "use GET");
+        return httpResponse(200, "OK", "text/plain",
+                            "GET  /stats\n"
+                            "POST /pause\n"
+                            "POST /resume\n"
+                            "POST /gens-per-frame?n=N\n"
+                            "POST /checkpoint\n"
+                            "GET  /viewport.png?x=X&y=Y&w=W&h=H&scale=S\n");
+    }
+    if (path == "/stats") {
+        if (!get)
+            return jsonError(405, "Method Not Allowed", "use GET");
+        return httpResponse(200, "OK", "application/json", statsJson());
+    }
+    if (path == "/pause" || path == "/resume") {
+        if (!post)
+            return jsonError(405, "Method Not Allowed", "use POST");
+        bool pause = path == "/pause";
+        pause_request.store(pause ? 1 : 0, std::memory_order_relaxed);
+        return httpResponse(200, "OK", "application/json", std::string("{\"paused\":") + (pause ? "true" : "false") + "}\n");
+    }
+    if (path == "/gens-per-frame") {
+        if (!post)
+            return jsonError(405, "Method Not Allowed", "use POST");
+        int n = 0;
+        if (!queryInt(query, "n", n) || n < 1)
+            return jsonError(400, "Bad Request", "n must be a positive integer");
+        gens_per_frame_request.store(n, std::memory_order_relaxed);
+        return httpResponse(200, "OK", "application/json", "{\"gens_per_frame\":" + std::to_string(n) + "}\n");
+    }
+    if (path == "/checkpoint") {
+        if (!post)
+            return jsonError(405, "Method Not Allowed", "use POST");
+        return checkpoint();
+    }
+    if (path == "/viewport.png") {
+        if (!get)
+            return jsonError(405, "Method Not Allowed", "use GET");
+        std::string error;
+        std::string png = viewportPNG(query, error);
+        return error.empty() ? httpResponse(200, "OK", "image/png", png) : jsonError(400, "Bad Request", error);
+    }
+    return jsonError(404, "Not Found", "unknown endpoint");
+}
+
+/*
+Formats the statistics of the newest snapshot, e.g.
+{"generation":1200,"population":5012,"width":160,"height":120,"rule":"B3/S23",
+ "backend":"OMP","threads":8,"logical_cpus":16,"physical_cores":8,"oversubscribed":false,
+ "paused":false,"gens_per_frame":1,"gens_per_sec":3054.2,"thread_busy_ms_per_sec":[101.3,99.8,...]}
+*/
+std::string StatusServer::statsJson() {
+    const CpuTopology& topology = cpuTopology();
+    source.acquire();
+    const Snapshot& snapshot = source.current();
+    std::ostringstream out;
+    out << "{\"generation\":" << snapshot.generation
+        << ",\"population\":" << (snapshot.generation >= 0 ? countPopulation(snapshot) : 0)
+        << ",\"width\":" << snapshot.width << ",\"height\":" << snapshot.height
+        << ",\"rule\":" << jsonString(RULE.name) << ",\"backend\":" << jsonString(backend_name)
+        << ",\"threads\":" << threads << ",\"logical_cpus\":" << topology.logical_cpus
+        << ",\"physical_cores\":" << topology.physical_cores << ",\"oversubscribed\":" << (threads > topology.logical_cpus ? "true" : "false")
+        << ",\"paused\":" << (paused_state.load(std::memory_order_relaxed) ? "true" : "false")
+        << ",\"gens_per_frame\":" << gens_per_frame_state.load(std::memory_order_relaxed)
+        << ",\"gens_per_sec\":" << gens_per_sec << ",\"thread_busy_ms_per_sec\":[";
+    for (int i = 0; i < threads; ++i)
+        out << (i ? "," : "") << busy_ms_per_sec[i];
+    out << "]}\n";
+    return out.str();
+}
+
+/*
+Writes the newest snapshot to checkpoint_<generation>.pgm in the working
+directory. The file is written on the server thread from the server's own
+snapshot, so the simulation keeps running meanwhile.
+*/
+std::string StatusServer::checkpoint() {
+    source.acquire();
+    const Snapshot& snapshot = source.current();
+    if (snapshot.generation < 0)
+        return jsonError(503, "Service Unavailable", "no generation published yet");
+    std::string path = "checkpoint_" + std::to_string(snapshot.generation) + ".pgm";
+    if (!writeCheckpoint(path, snapshot.cells, snapshot.width, snapshot.height, snapshot.generation))
+        return jsonError(500, "Internal Server Error", "cannot write " + path);
+    return httpResponse(200, "OK", "application/json",
+                        "{\"path\":" + jsonString(path) + ",\"generation\":" + std::to_string(snapshot.generation) + "}\n");
+}
+
+/*
+Renders a rectangle of the newest snapshot as a grayscale PNG, each cell a
+scale x scale block shaded like the window. The rectangle defaults to the
+whole grid and is clipped to it.
+
+Parameters:
+- query: Query string with optional x, y, w, h and scale parameters.
+- error: Reference receiving a message if the parameters are invalid.
+
+Returns:
+- The PNG file contents, empty on error.
+*/
+std::string StatusServer::viewportPNG(const std::string& query, std::string& error) {
+    source.acquire();
+    const Snapshot& snapshot = source.current();
+    if (snapshot.generation < 0) {
+        error = "no generation published yet";
+        return std::string();
+    }
+    int x = 0, y = 0, w = snapshot.width, h = snapshot.height, scale = 1;
+    queryInt(query, "x", x);
+    queryInt(query, "y", y);
+    queryInt(query, "w", w);
+    queryInt(query, "h", h);
+    queryInt(query, "scale", scale);
+    x = std::max(0, std::min(x, snapshot.width));
+    y = std::max(0, std::min(y, snapshot.height));
+    w = std::min(w, snapshot.width - x);
+    h = std::min(h, snapshot.height - y);
+    if (scale < 1 || scale > MAX_VIEWPORT_SCALE) {
+        error = "scale must be between 1 and " + std::to_string(MAX_VIEWPORT_SCALE);
+        return std::string();
+    }
+    if (w <= 0 || h <= 0 || static_cast<long long>(w) * h > MAX_VIEWPORT_PIXELS / (scale * scale)) {
+        error = "empty or oversized viewport";
+        return std::string();
+    }
+
+    int pitch = snapshot.width + 2;
+    int image_width = w * scale;
+    std::vector<uint8_t> pixels(static_cast<size_t>(image_width) * h * scale);
+    for (int row = 0; row < h; ++row) {
+        const uint8_t* cells = &snapshot.cells[static_cast<size_t>(y + row + 1) * pitch + x + 1];
+        uint8_t* line = &pixels[static_cast<size_t>(row) * scale * image_width];
+        for (int col = 0; col < w; ++col)
+            std::fill(line + col * scale, line + (col + 1) * scale, stateShade(cells[col]));
+        for (int copy = 1; copy < scale; ++copy)
+            std::copy(line, line + image_width, line + static_cast<size_t>(copy) * image_width);
+    }
+    std::vector<uint8_t> png = encodePNG(pixels.data(), image_width, h * scale);
+    return std::string(png.begin(), png.end());
+}
@@ -0,0 +1,85 @@
+/*
+Description:
+Status and control server for runs without a window. A single event-loop
+thread serves HTTP on 127.0.0.1: JSON statistics, pause and resume, the
+number of generations per frame, checkpoints and PNG images of any part of
+the grid. The simulation is never blocked: the server reads published
+snapshots and leaves requests in atomics that the simulation loop picks up
+between generations.
+*/
+
+#ifndef SERVER_H
+#define SERVER_H
+
+#include "snapshot.h"
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+#include <chrono>
+
+class StatusServer {
+public:
+    /*
+    Binds 127.0.0.1:port and starts the event-loop thread.
+    backend_name and threads are only used in the statistics.
+    */
+    StatusServer(int port, SnapshotBuffer& source, const std::string& backend_name, int threads);
+    ~StatusServer();
+    StatusServer(const StatusServer&) = delete;
+    StatusServer& operator=(const StatusServer&) = delete;
+
+    bool ok() const { return listen_fd >= 0; }
+
+    // Simulation side: pause request since the last call (1 pause, 0 resume, -1 none)
+    int takePauseRequest() { return pause_request.exchange(-1, std::memory_order_relaxed); }
+
+    // Simulation side: requested generations per frame since the last call, 0 if none
+    int takeGensPerFrameRequest() { return gens_per_frame_request.exchange(0, std::memory_order_relaxed); }
+
+    // Simulation side: reports the state the statistics show
+    void report(bool paused, int gens_per_frame) {
+        paused_state.store(paused, std::memory_order_relaxed);
+        gens_per_frame_state.store(gens_per_frame, std::memory_order_relaxed);
+    }
+
+private:
+    struct Connection {
+        int fd;
+        std::string request;   // Bytes received until the end of the header
+        std::string response;  // Bytes left to send
+        size_t sent = 0;
+        std::chrono::steady_clock::time_point opened;
+    };
+
+    void run();
+    void sample();
+    void acceptConnections(std::vector<Connection>& connections);
+    bool serviceConnection(Connection& connection, short events);
+    std::string handle(const std::string& method, const std::string& path, const std::string& query);
+    std::string statsJson();
+    std::string checkpoint();
+    std::string viewportPNG(const std::string& query, std::string& error);
+
+    SnapshotBuffer& source;
+    std::string backend_name;
+    int threads;
+    int listen_fd = -1;
+    int wake_pipe[2] = {-1, -1};  // Written by the destructor to end poll()
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+
+    std::atomic<int> pause_request{-1};
+    std::atomic<int> gens_per_frame_request{0};
+    std::atomic<bool> paused_state{false};
+    std::atomic<int> gens_per_frame_state{1};
+
+    // Rates sampled twice a second on the server thread
+    std::chrono::steady_clock::time_point last_sample;
+    long long sampled_generation = -1;
+    double gens_per_sec = 0;
+    std::vector<long long> sampled_busy_ns;  // THREAD_BUSY_NS at the last sample
+    std::vector<double> busy_ms_per_sec;     // Busy time of each thread per second of wall time
+};
+
+#endif
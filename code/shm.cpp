@@ -0,0 +1,88 @@
+/*
+Description:
+Shared-memory writer for the live view.
+*/
+
+#include "shm.h"
+#include "snapshot.h"
+#include <cstring>
+#include <cerrno>
+#include <new>
+#include <chrono>
+#include <iostream>
+
+/*
+Creates (or replaces) the named segment, sized for the current grid, and
+starts the thread that fills it.
+
+Parameters:
+- name: POSIX shared-memory name, e.g. "/life".
+- source: Snapshot buffer subscribed for this writer.
+*/
+SharedGridWriter::SharedGridWriter(const std::string& name, SnapshotBuffer& source) : name(name), source(source) {
+    uint64_t capacity = static_cast<uint64_t>(GRID_WIDTH) * GRID_HEIGHT;
+    size = sizeof(SharedGridHeader) + capacity;
+    int fd = shm_open(name.c_str(), O_CREAT | O_RDWR | O_TRUNC, 0644);
+    void* mapping = MAP_FAILED;
+    if (fd >= 0) {
+        if (ftruncate(fd, size) == 0)
+            mapping = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Cannot create shared memory " << name << ": " << std::strerror(errno) << std::endl;
+        if (fd >= 0)
+            shm_unlink(name.c_str());
+        return;
+    }
+
+    // Readers ignore the segment until the magic number is stored after the size fields
+    header = new (mapping) SharedGridHeader();
+    header->version = SHARED_GRID_VERSION;
+    header->width = GRID_WIDTH;
+    header->height = GRID_HEIGHT;
+    header->capacity = capacity;
+    header->sequence.store(0, std::memory_order_relaxed);
+    header->generation.store(-1, std::memory_order_relaxed);
+    header->checksum.store(0, std::memory_order_relaxed);
+    header->magic.store(SHARED_GRID_MAGIC, std::memory_order_release);
+    staging.resize(capacity);
+    thread = std::thread(&SharedGridWriter::run, this);
+}
+
+SharedGridWriter::~SharedGridWriter() {
+    stopping = true;
+    if (thread.joinable())
+        thread.join();
+    if (header) {
+        munmap(header, size);
+        shm_unlink(name.c_str());
+    }
+}
+
+/*
+Writer thread loop: takes the newest snapshot, strips its padding and
+checksums it, then copies it into the segment. The sequence number is odd
+only for the final copy, so readers rarely have to retry.
+*/
+void SharedGridWriter::run() {
+    uint8_t* cells = reinterpret_cast<uint8_t*>(header + 1);
+    while (!stopping) {
+        if (source.acquire()) {
+            const Snapshot& snapshot = source.current();
+            int pitch = snapshot.width + 2;
+            for (int y = 0; y < snapshot.height; ++y)
+                std::memcpy(&staging[static_cast<size_t>(y) * snapshot.width], &snapshot.cells[static_cast<size_t>(y + 1) * pitch + 1], snapshot.width);
+            uint64_t checksum = sharedGridChecksum(staging.data(), staging.size());
+
+            uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+            header->sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);  // Readers see the odd number before any new cell
+            std::memcpy(cells, staging.data(), staging.size());
+            header->generation.store(snapshot.generation, std::memory_order_relaxed);
+            header->checksum.store(checksum, std::memory_order_relaxed);
+            header->sequence.store(sequence + 2, std::memory_order_release);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
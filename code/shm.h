@@ -0,0 +1,182 @@
+/*
+Description:
+Live view of the simulation in a POSIX shared-memory segment. The segment
+starts with a header guarded by a sequence lock, followed by the cells of
+the newest published generation without padding. This header is also the
+whole reader library: other processes include it, attach with
+SharedGridReader and read frames in place.
+*/
+
+#ifndef SHM_H
+#define SHM_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if ATOMIC_LLONG_LOCK_FREE != 2 || ATOMIC_INT_LOCK_FREE != 2
+#error "Shared grid headers need lock-free atomics to work across processes"
+#endif
+
+const uint32_t SHARED_GRID_MAGIC = 0x4546494C;  // "LIFE" in little-endian byte order
+const uint32_t SHARED_GRID_VERSION = 1;
+
+/*
+Segment header. The size fields are written once before the magic number
+is stored; the frame fields change with every frame and are only
+consistent when the sequence number is even and unchanged across the read.
+*/
+struct alignas(64) SharedGridHeader {
+    std::atomic<uint32_t> magic;         // SHARED_GRID_MAGIC once the segment is initialized
+    uint32_t version;                    // SHARED_GRID_VERSION
+    int32_t width, height;               // Cells per row and rows
+    uint64_t capacity;                   // Bytes reserved for cells after the header
+    std::atomic<uint64_t> sequence;      // Odd while the writer is updating the frame
+    std::atomic<int64_t> generation;     // Generation of the frame, -1 before the first one
+    std::atomic<uint64_t> checksum;      // sharedGridChecksum of the frame's cells
+};
+
+/*
+Checksum of a frame: FNV-1a over 64-bit words, with the trailing bytes
+folded in one at a time.
+
+Parameters:
+- cells: Pointer to the cells.
+- size: Number of cells.
+
+Returns:
+- The 64-bit checksum.
+*/
+inline uint64_t sharedGridChecksum(const uint8_t* cells, size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        __builtin_memcpy(&word, cells + i, 8);
+        hash = (hash ^ word) * 1099511628211ULL;
+    }
+    for (; i < size; ++i)
+        hash = (hash ^ cells[i]) * 1099511628211ULL;
+    return hash;
+}
+
+// Frame fields read under the sequence lock
+struct SharedGridFrame {
+    const uint8_t* cells;  // Points into the segment, width * height cells
+    int width, height;
+    int64_t generation;
+    uint64_t checksum;
+};
+
+/*
+Read-only attachment to a segment created by a running simulation.
+Reads are zero-copy: read() hands the visitor a pointer into the segment
+and then checks that the writer did not touch the frame meanwhile.
+*/
+class SharedGridReader {
+public:
+    SharedGridReader() {}
+    ~SharedGridReader() { detach(); }
+    SharedGridReader(const SharedGridReader&) = delete;
+    SharedGridReader& operator=(const SharedGridReader&) = delete;
+
+    // Maps the segment with the given name (e.g. "/life"), false if it does not exist or is not a grid
+    bool attach(const std::string& name) {
+        detach();
+        int fd = shm_open(name.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+        struct stat info;
+        if (fstat(fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(SharedGridHeader)) {
+            void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            if (mapping != MAP_FAILED) {
+                base = mapping;
+                size = info.st_size;
+            }
+        }
+        close(fd);
+        const SharedGridHeader* h = header();
+        if (!h || h->magic.load(std::memory_order_acquire) != SHARED_GRID_MAGIC || h->version != SHARED_GRID_VERSION ||
+            sizeof(SharedGridHeader) + h->capacity > size ||
+            static_cast<uint64_t>(h->width) * static_cast<uint64_t>(h->height) > h->capacity) {
+            detach();
+            return false;
+        }
+        return true;
+    }
+
+    void detach() {
+        if (base)
+            munmap(base, size);
+        base = nullptr;
+        size = 0;
+    }
+
+    const SharedGridHeader* header() const { return static_cast<const SharedGridHeader*>(base); }
+
+    /*
+    Calls visit(const SharedGridFrame&) on the current frame in place. The
+    visitor may see a frame being overwritten, so it must not trust what it
+    reads until read() returns true; on false the frame was torn (or none
+    was written yet) and the caller retries.
+    */
+    template <class Visitor>
+    bool read(Visitor&& visit) const {
+        const SharedGridHeader* h = header();
+        uint64_t before = h->sequence.load(std::memory_order_acquire);
+        if (before & 1)
+            return false;
+        SharedGridFrame frame;
+        frame.cells = reinterpret_cast<const uint8_t*>(h + 1);
+        frame.width = h->width;
+        frame.height = h->height;
+        frame.generation = h->generation.load(std::memory_order_relaxed);
+        frame.checksum = h->checksum.load(std::memory_order_relaxed);
+        if (frame.generation < 0)
+            return false;
+        visit(static_cast<const SharedGridFrame&>(frame));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return h->sequence.load(std::memory_order_relaxed) == before;
+    }
+
+private:
+    void* base = nullptr;
+    size_t size = 0;
+};
+
+class SnapshotBuffer;
+
+/*
+Creates the segment and, on its own thread, copies every new snapshot from
+the source into it under the sequence lock. The segment is removed again
+when the writer is destroyed.
+*/
+class SharedGridWriter {
+public:
+    SharedGridWriter(const std::string& name, SnapshotBuffer& source);
+    ~SharedGridWriter();
+    SharedGridWriter(const SharedGridWriter&) = delete;
+    SharedGridWriter& operator=(const SharedGridWriter&) = delete;
+
+    bool ok() const { return header != nullptr; }
+
+private:
+    void run();
+
+    std::string name;
+    SnapshotBuffer& source;
+    SharedGridHeader* header = nullptr;
+    size_t size = 0;
+    std::vector<uint8_t> staging;  // Unpadded cells, checksummed before the frame is opened
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+#endif
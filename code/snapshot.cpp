@@ -0,0 +1,57 @@
+/*
+Description:
+Triple-buffered snapshot publishing.
+*/
+
+#include "snapshot.h"
+#include <cstring>
+
+/*
+Copies the grid into the writer's back slot, then exchanges that slot with
+the middle one. The release half of the exchange makes the copy visible to
+the reader that takes the slot; the slot handed back is either the one the
+reader just left or the previous unread snapshot, and neither is being read.
+
+Parameters:
+- grid: Reference to the grid to publish.
+- generation: Generation number of the grid.
+
+Returns:
+- void
+*/
+void SnapshotBuffer::publish(const Grid& grid, long long generation) {
+    Snapshot& slot = slots[back];
+    if (slot.cells.size() != grid.size())
+        slot.cells.resize(grid.size());
+    std::memcpy(slot.cells.data(), grid.data(), grid.size());
+    slot.width = GRID_WIDTH;
+    slot.height = GRID_HEIGHT;
+    slot.generation = generation;
+    back = middle.exchange(back | FRESH, std::memory_order_acq_rel) & 3;
+}
+
+/*
+Swaps the reader's front slot with the middle slot if the writer published
+since the last call. The acquire half of the exchange pairs with the
+writer's release, so the new front slot is fully written.
+
+Returns:
+- true if a newer snapshot is now current, false otherwise.
+*/
+bool SnapshotBuffer::acquire() {
+    if (!(middle.load(std::memory_order_relaxed) & FRESH))
+        return false;
+    front = middle.exchange(front, std::memory_order_acq_rel) & 3;
+    return true;
+}
+
+SnapshotBuffer& SnapshotPublisher::subscribe() {
+    buffers.emplace_back(new SnapshotBuffer());
+    return *buffers.back();
+}
+
+void SnapshotPublisher::publish(const Grid& grid, long long generation, bool every_reader) {
+    for (auto& buffer : buffers)
+        if (every_reader || buffer->taken())
+            buffer->publish(grid, generation);
+}
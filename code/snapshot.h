@@ -0,0 +1,73 @@
+/*
+Description:
+Lock-free handoff of completed generations from the simulation to reader
+threads. The simulation publishes a copy of the grid, readers pick up the
+newest one whenever they are ready without ever blocking the simulation.
+*/
+
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "life.h"
+#include <atomic>
+#include <memory>
+#include <vector>
+
+// A published generation
+struct Snapshot {
+    Grid cells;                 // Padded copy of the grid
+    int width = 0, height = 0;  // GRID_WIDTH and GRID_HEIGHT when it was published
+    long long generation = -1;  // -1 until the first publish
+};
+
+/*
+Triple buffer between one writer and one reader. The writer fills its back
+slot and swaps it with the middle slot in a single atomic exchange; the
+reader swaps its front slot with the middle slot when a newer snapshot is
+waiting. Each side only ever touches the slot it owns, so neither side
+waits for the other and the reader always gets the latest complete
+generation. Generations published faster than the reader looks are dropped.
+*/
+class SnapshotBuffer {
+public:
+    // Writer side: copies the grid into the back slot and makes it the newest snapshot
+    void publish(const Grid& grid, long long generation);
+
+    // Writer side: false while the last published snapshot is still waiting for the reader
+    bool taken() const { return !(middle.load(std::memory_order_relaxed) & FRESH); }
+
+    // Reader side: takes the newest snapshot, false if nothing was published since the last call
+    bool acquire();
+
+    // Reader side: the snapshot taken by the last successful acquire
+    const Snapshot& current() const { return slots[front]; }
+
+private:
+    static const int FRESH = 4;    // Set in middle while the writer's latest slot is unread
+
+    Snapshot slots[3];
+    std::atomic<int> middle{1};    // Slot index exchanged between the two sides, plus FRESH
+    int back = 0;                  // Owned by the writer
+    int front = 2;                 // Owned by the reader
+};
+
+/*
+Fans published generations out to one SnapshotBuffer per reader, so a slow
+reader only ever holds back its own slots. Readers subscribe before the
+simulation starts; publishing with no subscribers costs nothing. A reader
+that has not taken its last snapshot is skipped unless every_reader is set,
+so each generation is copied only for the readers waiting for one and the
+rest catch up on the caller's frame cadence.
+*/
+class SnapshotPublisher {
+public:
+    // Adds a reader (not thread safe, call before the first publish)
+    SnapshotBuffer& subscribe();
+
+    void publish(const Grid& grid, long long generation, bool every_reader);
+
+private:
+    std::vector<std::unique_ptr<SnapshotBuffer>> buffers;
+};
+
+#endif
@@ -0,0 +1,87 @@
+/*
+Description:
+Moving-average throughput statistics and the population counter.
+*/
+
+#include "stats.h"
+#include "rules.h"
+#include <cstdio>
+#include <chrono>
+
+// Weights given to the newest sample
+static const double KERNEL_ALPHA = 0.02;  // Per generation, smooths over roughly 50 generations
+static const double RENDER_ALPHA = 0.1;   // Per frame
+static const double RATE_ALPHA = 0.3;     // Per rate sample (one per title update)
+
+static void blend(double& average, double sample, double alpha, bool primed) {
+    average = primed ? average + alpha * (sample - average) : sample;
+}
+
+void ThroughputStats::addGeneration(double kernel_seconds) {
+    blend(kernel_ms, kernel_seconds * 1000.0, KERNEL_ALPHA, kernel_ms > 0);
+    ++generations;
+}
+
+void ThroughputStats::addFrame(double render_seconds) {
+    blend(render_ms, render_seconds * 1000.0, RENDER_ALPHA, render_ms > 0);
+    ++frames;
+}
+
+void ThroughputStats::sampleRates(double elapsed_seconds) {
+    if (elapsed_seconds <= 0)
+        return;
+    blend(gens_per_sec, generations / elapsed_seconds, RATE_ALPHA, primed);
+    blend(frames_per_sec, frames / elapsed_seconds, RATE_ALPHA, primed);
+    primed = true;
+    generations = 0;
+    frames = 0;
+}
+
+/*
+Formats the averages, e.g.
+"Game of Life - OMP x8 - gen 1200 - 3054 gens/s - kernel 0.31 ms - render 1.20 ms - 60 fps - pop 5012".
+*/
+std::string ThroughputStats::summary(const std::string& backend_name, int threads, long long generation, bool paused, long long population) const {
+    char text[256];
+    int length = std::snprintf(text, sizeof(text), "Game of Life - %s x%d - gen %lld%s - %.0f gens/s - kernel %.2f ms - render %.2f ms - %.0f fps",
+                               backend_name.c_str(), threads, generation, paused ? " (paused)" : "", gens_per_sec, kernel_ms,
+                               render_ms, frames_per_sec);
+    if (population >= 0 && length > 0 && length < static_cast<int>(sizeof(text)))
+        std::snprintf(text + length, sizeof(text) - length, " - pop %lld", population);
+    return text;
+}
+
+/*
+Counts the live cells of a snapshot. Cells past the first state of
+Generations rules are dying and do not count; any level above zero counts
+for Lenia.
+*/
+long long countPopulation(const Snapshot& snapshot) {
+    int pitch = snapshot.width + 2;
+    long long count = 0;
+    for (int y = 1; y <= snapshot.height; ++y) {
+        const uint8_t* row = &snapshot.cells[static_cast<size_t>(y) * pitch + 1];
+        for (int x = 0; x < snapshot.width; ++x)
+            count += RULE.continuous ? row[x] != 0 : row[x] == 1;
+    }
+    return count;
+}
+
+PopulationCounter::PopulationCounter(SnapshotBuffer& source) : source(source), thread(&PopulationCounter::run, this) {}
+
+PopulationCounter::~PopulationCounter() {
+    stopping = true;
+    thread.join();
+}
+
+/*
+Counter thread loop: counts the live cells of the newest snapshot, if there
+is one.
+*/
+void PopulationCounter::run() {
+    while (!stopping) {
+        if (source.acquire())
+            live.store(countPopulation(source.current()), std::memory_order_relaxed);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+}
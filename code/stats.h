@@ -0,0 +1,66 @@
+/*
+Description:
+Moving-average throughput statistics and the population shown in the
+window title.
+*/
+
+#ifndef STATS_H
+#define STATS_H
+
+#include "snapshot.h"
+#include <string>
+#include <atomic>
+#include <thread>
+
+/*
+Exponentially weighted moving averages of kernel time, render time,
+generations per second and frames per second. Samples come from timings the
+main loop already takes, so keeping the statistics costs no extra passes
+over the grid.
+*/
+class ThroughputStats {
+public:
+    void addGeneration(double kernel_seconds);
+    void addFrame(double render_seconds);
+
+    // Folds the generations and frames counted since the last call into the rate averages
+    void sampleRates(double elapsed_seconds);
+
+    // Formats the averages and the population (left out while negative) for the window title
+    std::string summary(const std::string& backend_name, int threads, long long generation, bool paused, long long population) const;
+
+private:
+    double kernel_ms = 0;      // Average time per generation spent in the backend
+    double render_ms = 0;      // Average time per drawn frame
+    double gens_per_sec = 0;
+    double frames_per_sec = 0;
+    int generations = 0;       // Counted since the last rate sample
+    int frames = 0;
+    bool primed = false;       // First samples replace the averages instead of blending
+};
+
+// Live cells of a snapshot under the active rule
+long long countPopulation(const Snapshot& snapshot);
+
+/*
+Counts the live cells of the newest published generation on its own thread,
+ten times a second, so the count never holds up the simulation.
+*/
+class PopulationCounter {
+public:
+    explicit PopulationCounter(SnapshotBuffer& source);
+    ~PopulationCounter();
+
+    // Live cells in the last counted snapshot, -1 before the first count
+    long long population() const { return live.load(std::memory_order_relaxed); }
+
+private:
+    void run();
+
+    SnapshotBuffer& source;
+    std::atomic<long long> live{-1};
+    std::atomic<bool> stopping{false};
+    std::thread thread;
+};
+
+#endif
@@ -0,0 +1,50 @@
+/*
+Description:
+Test driver for ctest: the differential check of -v on one rule of every
+kind, built from the kernels and backends alone so it runs without SFML.
+Usage: LabTests [generations [seed ...]], by default a quick run of
+TEST_GENERATIONS generations from TEST_SEED.
+*/
+
+#include "life.h"
+#include "rules.h"
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// One rule per kernel: Life, other Life-like rules (bit-packed in HYB), Generations, Hensel and
+// hexagonal lookups, Larger than Life boxes and diamonds, Lenia direct and FFT, and both 3D kernels
+static const char* TEST_RULES[] = {
+    "B3/S23", "B36/S23", "/2/3", "B2-a/S12", "B2/S34H", "R5,C0,M1,S34..58,B34..45,NM", "R2,C3,M0,S1..4,B2..3,NN",
+    "LENIA,R3,T10,M0.15,S0.015", "LENIA", "3D4555", "3D4555/BYTE",
+};
+static const int TEST_GENERATIONS = 12;
+static const uint64_t TEST_SEED = 2024;
+
+int main(int argc, char* argv[]) {
+    int generations = argc > 1 ? std::atoi(argv[1]) : TEST_GENERATIONS;
+    std::vector<uint64_t> seeds;
+    for (int i = 2; i < argc; ++i)
+        seeds.push_back(std::strtoull(argv[i], nullptr, 10));
+    if (seeds.empty())
+        seeds.push_back(TEST_SEED);
+    if (generations < 1) {
+        std::cerr << "Usage: " << argv[0] << " [generations [seed ...]]" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int failures = 0;
+    for (const char* spec : TEST_RULES) {
+        if (!parseRule(spec, RULE)) {
+            std::cerr << "Invalid test rule " << spec << std::endl;
+            ++failures;
+            continue;
+        }
+        for (uint64_t seed : seeds) {
+            std::cout << "Seed " << seed << ", " << generations << " generations:" << std::endl;
+            if (!verifyBackends(generations, seed))
+                ++failures;
+        }
+    }
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+/*
+Description:
+CPU topology detection from /sys/devices/system/cpu and the affinity mask
+of the process, and pinning of threads to physical cores.
+*/
+
+#include "topology.h"
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <thread>
+#include <utility>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+static const char* SYSFS_CPU = "/sys/devices/system/cpu/cpu";
+
+// Reads the first line of a sysfs file, false if it does not exist
+static bool readLine(const std::string& path, std::string& line) {
+    std::ifstream in(path);
+    return in && std::getline(in, line);
+}
+
+static bool readInt(const std::string& path, int& value) {
+    std::string line;
+    if (!readLine(path, line))
+        return false;
+    value = std::atoi(line.c_str());
+    return true;
+}
+
+// Parses a CPU list such as "0-3,8,10-11"
+static std::vector<int> parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream in(list);
+    std::string range;
+    while (std::getline(in, range, ',')) {
+        if (range.empty())
+            continue;
+        size_t dash = range.find('-');
+        int first = std::atoi(range.c_str());
+        int last = dash == std::string::npos ? first : std::atoi(range.c_str() + dash + 1);
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+// Logical CPUs the process may run on, in CPU order
+static std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+#endif
+    return cpus;
+}
+
+/*
+Fills the cores, packages and caches of the allowed CPUs from sysfs.
+
+Parameters:
+- cpus: Allowed logical CPUs.
+- topology: Topology to fill in.
+
+Returns:
+- true if every CPU had its package and core id, false otherwise.
+*/
+static bool readSysfs(const std::vector<int>& cpus, CpuTopology& topology) {
+    std::map<std::pair<int, int>, size_t> core_index;  // (package, core id) -> index in topology.cores
+    std::vector<int> packages;
+    for (int cpu : cpus) {
+        std::string dir = SYSFS_CPU + std::to_string(cpu) + "/topology/";
+        int package = 0, core = 0;
+        if (!readInt(dir + "physical_package_id", package) || !readInt(dir + "core_id", core))
+            return false;
+        auto inserted = core_index.insert(std::make_pair(std::make_pair(package, core), topology.cores.size()));
+        if (inserted.second)
+            topology.cores.push_back(std::vector<int>());
+        topology.cores[inserted.first->second].push_back(cpu);
+        if (std::find(packages.begin(), packages.end(), package) == packages.end())
+            packages.push_back(package);
+    }
+    topology.physical_cores = static_cast<int>(topology.cores.size());
+    topology.packages = static_cast<int>(packages.size());
+    for (const auto& siblings : topology.cores)
+        topology.threads_per_core = std::max(topology.threads_per_core, static_cast<int>(siblings.size()));
+
+    // Caches of the first CPU, counting only allowed CPUs as sharers
+    for (int index = 0;; ++index) {
+        std::string dir = SYSFS_CPU + std::to_string(cpus[0]) + "/cache/index" + std::to_string(index) + "/";
+        CacheLevel cache;
+        std::string size, shared;
+        if (!readInt(dir + "level", cache.level) || !readLine(dir + "type", cache.type) || !readLine(dir + "size", size))
+            break;
+        cache.size_kb = std::atol(size.c_str());
+        if (size.find('M') != std::string::npos)
+            cache.size_kb *= 1024;
+        if (readLine(dir + "shared_cpu_list", shared)) {
+            std::vector<int> sharers = parseCpuList(shared);
+            cache.shared_by = std::max(1, static_cast<int>(std::count_if(sharers.begin(), sharers.end(), [&](int cpu) {
+                return std::binary_search(cpus.begin(), cpus.end(), cpu);
+            })));
+        }
+        topology.caches.push_back(cache);
+    }
+    return true;
+}
+
+static CpuTopology detectTopology() {
+    CpuTopology topology;
+    std::vector<int> cpus = allowedCpus();
+    if (!cpus.empty() && readSysfs(cpus, topology)) {
+        topology.logical_cpus = static_cast<int>(cpus.size());
+        topology.from_sysfs = true;
+        return topology;
+    }
+    // Without sysfs every logical CPU counts as a core
+    topology = CpuTopology();
+    int count = cpus.empty() ? static_cast<int>(std::thread::hardware_concurrency()) : static_cast<int>(cpus.size());
+    topology.logical_cpus = topology.physical_cores = std::max(1, count);
+    return topology;
+}
+
+const CpuTopology& cpuTopology() {
+    static const CpuTopology topology = detectTopology();
+    return topology;
+}
+
+static std::string formatSize(long size_kb) {
+    return size_kb >= 1024 && size_kb % 1024 == 0 ? std::to_string(size_kb / 1024) + "M" : std::to_string(size_kb) + "K";
+}
+
+std::string describeTopology(const CpuTopology& topology) {
+    std::ostringstream out;
+    out << topology.physical_cores << (topology.physical_cores == 1 ? " core, " : " cores, ")
+        << topology.logical_cpus << (topology.logical_cpus == 1 ? " logical CPU" : " logical CPUs");
+    if (!topology.from_sysfs)
+        return out.str() + " (no topology information)";
+    out << " (" << topology.threads_per_core << " per core), " << topology.packages
+        << (topology.packages == 1 ? " package" : " packages");
+    for (const CacheLevel& cache : topology.caches)
+        out << ", L" << cache.level << (cache.type == "Data" ? "d" : cache.type == "Instruction" ? "i" : "") << " "
+            << formatSize(cache.size_kb) << "/" << cache.shared_by;
+    return out.str();
+}
+
+bool warnOversubscription(int threads, const char* thread_label) {
+    const CpuTopology& topology = cpuTopology();
+    const char* label = thread_label ? thread_label : "threads";
+    if (threads > topology.logical_cpus) {
+        std::cerr << "Warning: " << threads << " " << label << " on " << topology.logical_cpus
+                  << (topology.logical_cpus == 1 ? " logical CPU" : " logical CPUs") << " oversubscribe the host and will time-share CPUs; -n " << topology.physical_cores
+                  << " runs one thread per physical core." << std::endl;
+        return true;
+    }
+    if (threads > topology.physical_cores)
+        std::cerr << "Note: " << threads << " " << label << " on " << topology.physical_cores
+                  << " physical cores share cores with their SMT siblings; -n " << topology.physical_cores
+                  << " runs one thread per physical core." << std::endl;
+    return false;
+}
+
+bool pinThreadToCore(int core) {
+    const CpuTopology& topology = cpuTopology();
+    if (core < 0 || core >= static_cast<int>(topology.cores.size()))
+        return false;
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int cpu : topology.cores[core])
+        CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
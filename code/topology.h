@@ -0,0 +1,57 @@
+/*
+Description:
+CPU topology of the host as seen by this process: the logical CPUs it may
+run on, the physical cores and packages they belong to and the caches they
+share. Read from sysfs on Linux, with std::thread::hardware_concurrency()
+as the fallback elsewhere.
+*/
+
+#ifndef TOPOLOGY_H
+#define TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+struct CacheLevel {
+    int level = 0;
+    std::string type;   // Data, Instruction or Unified
+    long size_kb = 0;
+    int shared_by = 1;  // Allowed logical CPUs sharing one instance of this cache
+};
+
+struct CpuTopology {
+    int logical_cpus = 1;                 // CPUs in the affinity mask of the process
+    int physical_cores = 1;               // Cores among them, SMT siblings counted once
+    int packages = 1;                     // Sockets among them
+    int threads_per_core = 1;             // Most allowed SMT siblings on any one core
+    std::vector<std::vector<int>> cores;  // Allowed logical CPUs of each core, in CPU order
+    std::vector<CacheLevel> caches;       // Caches of the first allowed CPU, innermost first
+    bool from_sysfs = false;              // False when only the CPU count is known
+};
+
+// Topology detected on first use
+const CpuTopology& cpuTopology();
+
+// One-line description, e.g. "8 cores, 16 logical CPUs (2 per core), 1 package, L1d 48K/2, L2 2048K/2, L3 30720K/16"
+std::string describeTopology(const CpuTopology& topology);
+
+/*
+Checks a compute thread count against the topology and prints a warning on
+std::cerr when it exceeds the logical CPUs (threads time-share CPUs) or the
+physical cores (threads share cores with their SMT siblings).
+
+Returns:
+- true if threads exceeds the logical CPUs, false otherwise.
+*/
+bool warnOversubscription(int threads, const char* thread_label);
+
+/*
+Restricts the calling thread to the logical CPUs of one physical core so
+that no two pinned threads share a core.
+
+Returns:
+- true if the thread was pinned, false if core is out of range or pinning is unsupported.
+*/
+bool pinThreadToCore(int core);
+
+#endif
@@ -0,0 +1,301 @@
+/*
+Description:
+Differential correctness check that runs every registered backend from the
+same seeded state and compares the grids each generation against a simple
+bounds-checked reference implementation of the active rule.
+*/
+
+#include "life.h"
+#include "rules.h"
+#include "volume.h"
+#include "lenia.h"
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+// Odd and degenerate grid sizes exercise uneven thread splits and the padding
+static const int VERIFY_SIZES[][2] = {
+    {1, 1}, {3, 5}, {17, 13}, {31, 1}, {1, 29}, {63, 65}, {127, 97}, {257, 3},
+};
+static const int VERIFY_THREADS[] = {2, 3, 5, 8, 13};
+
+// Grids for the FFT check: smaller than, close to and larger than the default Lenia kernel
+static const int VERIFY_FFT_SIZES[][2] = {{9, 7}, {31, 17}, {64, 48}, {97, 113}};
+static const int LENIA_TOLERANCE = 1;  // Levels (of 255) the FFT and direct paths may differ by after rounding
+
+// Volumes that cover one, two and three words per row of the bit-packed kernel
+static const int VERIFY_VOLUMES[][3] = {
+    {1, 1, 1}, {5, 3, 7}, {17, 13, 6}, {63, 9, 5}, {64, 4, 4}, {65, 7, 3}, {130, 5, 9},
+};
+
+/*
+Computes the next generation without relying on the padding.
+Every neighbor access is bounds checked so this shares no indexing logic with
+the backends it verifies.
+
+Parameters:
+- grid_current: Reference to the current grid state.
+- grid_next: Reference to the grid where the next state will be stored.
+
+Returns:
+- void
+*/
+static void updateGridReference(const Grid& grid_current, Grid& grid_next) {
+    for (int y = 0; y < GRID_HEIGHT; ++y) {
+        for (int x = 0; x < GRID_WIDTH; ++x) {
+            int neighbors = 0;  // Neighbors in the live state
+            int pattern = 0;    // Live cells of the 3x3 block in reading order, for lookup rules
+            for (int dy = -RULE.range; dy <= RULE.range; ++dy) {
+                for (int dx = -RULE.range; dx <= RULE.range; ++dx) {
+                    int ny = y + dy, nx = x + dx;
+                    bool inside = RULE.neighborhood == 'M' || std::abs(dx) + std::abs(dy) <= RULE.range;
+                    bool self = !dx && !dy;
+                    bool live = ny >= 0 && ny < GRID_HEIGHT && nx >= 0 && nx < GRID_WIDTH && grid_current[(ny + 1) * PITCH + nx + 1] == 1;
+                    if (live && inside && (!self || RULE.middle))
+                        ++neighbors;
+                    if (live && std::abs(dx) <= 1 && std::abs(dy) <= 1)
+                        pattern |= 1 << ((dy + 1) * 3 + dx + 1);
+                }
+            }
+            int state = grid_current[(y + 1) * PITCH + x + 1];
+            int next = (RULE.patterns.empty() || state > 1) ? nextState(RULE, state, neighbors) : RULE.patterns[pattern];
+            grid_next[(y + 1) * PITCH + x + 1] = static_cast<uint8_t>(next);
+        }
+    }
+}
+
+/*
+Computes the next generation of a volume without relying on the padding,
+counting the 26 neighbors of every cell with bounds checks.
+
+Parameters:
+- voxels_current: Reference to the current volume in the padded byte layout.
+- voxels_next: Reference to the volume where the next state will be stored.
+
+Returns:
+- void
+*/
+static void updateVoxelsReference(const Grid& voxels_current, Grid& voxels_next) {
+    auto at = [](int x, int y, int z) { return (static_cast<size_t>(z + 1) * (GRID_HEIGHT + 2) + y + 1) * PITCH + x + 1; };
+    for (int z = 0; z < GRID_DEPTH; ++z) {
+        for (int y = 0; y < GRID_HEIGHT; ++y) {
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                int neighbors = 0;
+                for (int dz = -1; dz <= 1; ++dz) {
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        for (int dx = -1; dx <= 1; ++dx) {
+                            int nx = x + dx, ny = y + dy, nz = z + dz;
+                            if ((dx || dy || dz) && nx >= 0 && nx < GRID_WIDTH && ny >= 0 && ny < GRID_HEIGHT && nz >= 0 && nz < GRID_DEPTH)
+                                neighbors += voxels_current[at(nx, ny, nz)];
+                        }
+                    }
+                }
+                voxels_next[at(x, y, z)] = static_cast<uint8_t>(nextState(RULE, voxels_current[at(x, y, z)], neighbors));
+            }
+        }
+    }
+}
+
+/*
+Runs both 3D kernels on every registered backend for the given number of
+generations on each verification volume and thread count, comparing volume
+hashes with the reference implementation after every generation.
+
+Parameters:
+- generations: Number of generations to run per configuration.
+- seed: Seed used for every initial volume.
+
+Returns:
+- true if all kernels matched the reference, false otherwise.
+*/
+static bool verifyVolumes(int generations, uint64_t seed) {
+    int saved_width = GRID_WIDTH, saved_height = GRID_HEIGHT, saved_depth = GRID_DEPTH, saved_threads = NUM_THREADS;
+    int num_sizes = sizeof(VERIFY_VOLUMES) / sizeof(VERIFY_VOLUMES[0]);
+    int num_thread_counts = sizeof(VERIFY_THREADS) / sizeof(VERIFY_THREADS[0]);
+    int failures = 0;
+
+    for (int s = 0; s < num_sizes; ++s) {
+        setGridSize(VERIFY_VOLUMES[s][0], VERIFY_VOLUMES[s][1]);
+        GRID_DEPTH = VERIFY_VOLUMES[s][2];
+
+        // Record the reference hash of every generation once per size
+        std::vector<uint64_t> expected(generations + 1);
+        Grid ref_current, ref_next;
+        seedVolume(seed);
+        copyVoxels(ref_current);
+        ref_next = ref_current;
+        expected[0] = hashVoxels(ref_current);
+        for (int g = 1; g <= generations; ++g) {
+            updateVoxelsReference(ref_current, ref_next);
+            std::swap(ref_current, ref_next);
+            expected[g] = hashVoxels(ref_current);
+        }
+
+        for (int packed = 0; packed < 2; ++packed) {
+            for (int b = 0; b < NUM_BACKENDS; ++b) {
+                int runs = BACKENDS[b].thread_label ? num_thread_counts : 1;
+                for (int t = 0; t < runs; ++t) {
+                    NUM_THREADS = VERIFY_THREADS[t];
+                    seedVolume(seed);
+                    Grid voxels;
+                    for (int g = 1; g <= generations; ++g) {
+                        stepVolume(&BACKENDS[b], packed);
+                        copyVoxels(voxels);
+                        if (hashVoxels(voxels) != expected[g]) {
+                            std::cerr << "MISMATCH: " << BACKENDS[b].name << (packed ? " bit-packed" : " bytes") << " (" << RULE.name << ") on "
+                                      << GRID_WIDTH << "x" << GRID_HEIGHT << "x" << GRID_DEPTH << " with " << NUM_THREADS
+                                      << " threads at generation " << g << std::endl;
+                            ++failures;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    setGridSize(saved_width, saved_height);
+    GRID_DEPTH = saved_depth;
+    NUM_THREADS = saved_threads;
+
+    std::cout << (failures ? "FAIL" : "PASS") << ": " << RULE.name << ", " << NUM_BACKENDS << " backends, 2 kernels, " << num_sizes
+              << " volumes, " << generations << " generations, seed " << seed << std::endl;
+    return failures == 0;
+}
+
+/*
+Checks the FFT convolution of large Lenia kernels against direct
+convolution. The backends all run the same FFT code in the same order, so
+comparing them with each other cannot catch an error in it. Each
+generation starts both paths from the same grid, the FFT result, and
+compares every cell within LENIA_TOLERANCE, since the two paths add the
+same products in a different order.
+
+Parameters:
+- generations: Number of generations to compare per size.
+- seed: Seed used for every initial grid.
+
+Returns:
+- true if the paths agreed on every cell, false otherwise.
+*/
+static bool verifyLeniaConvolution(int generations, uint64_t seed) {
+    int saved_direct_range = LENIA_DIRECT_RANGE;
+    int num_sizes = sizeof(VERIFY_FFT_SIZES) / sizeof(VERIFY_FFT_SIZES[0]);
+    int failures = 0, largest = 0;
+    for (int s = 0; s < num_sizes; ++s) {
+        setGridSize(VERIFY_FFT_SIZES[s][0], VERIFY_FFT_SIZES[s][1]);
+        int cells = (GRID_HEIGHT + 2) * PITCH;
+        Grid grid_current(cells, 0), grid_fft(cells, 0), grid_direct(cells, 0);
+        seedRandomGrid(grid_current, seed);
+        for (int g = 1; g <= generations; ++g) {
+            LENIA_DIRECT_RANGE = saved_direct_range;
+            updateGrid(&BACKENDS[0], grid_current, grid_fft);
+            LENIA_DIRECT_RANGE = RULE.range;  // Same kernel through the direct path
+            updateGrid(&BACKENDS[0], grid_current, grid_direct);
+            int difference = 0;
+            for (int i = 0; i < cells; ++i)
+                difference = std::max(difference, std::abs(grid_fft[i] - grid_direct[i]));
+            largest = std::max(largest, difference);
+            if (difference > LENIA_TOLERANCE) {
+                std::cerr << "MISMATCH: FFT convolution (" << RULE.name << ") on " << GRID_WIDTH << "x" << GRID_HEIGHT
+                          << " differs from direct convolution by " << difference << " levels at generation " << g << std::endl;
+                ++failures;
+                break;
+            }
+            std::swap(grid_current, grid_fft);
+        }
+    }
+    LENIA_DIRECT_RANGE = saved_direct_range;
+    std::cout << (failures ? "FAIL" : "PASS") << ": " << RULE.name << ", FFT against direct convolution on " << num_sizes
+              << " grid sizes, " << generations << " generations, largest difference " << largest << " levels" << std::endl;
+    return failures == 0;
+}
+
+/*
+Runs every registered backend for the given number of generations on each
+verification grid size and thread count, comparing grid hashes with the
+reference implementation after every generation.
+
+Parameters:
+- generations: Number of generations to run per configuration.
+- seed: Seed used for every initial grid.
+
+Returns:
+- true if all backends matched the reference, false otherwise.
+*/
+bool verifyBackends(int generations, uint64_t seed) {
+    if (RULE.volume)
+        return verifyVolumes(generations, seed);
+
+    int saved_width = GRID_WIDTH, saved_height = GRID_HEIGHT, saved_threads = NUM_THREADS;
+    int num_sizes = sizeof(VERIFY_SIZES) / sizeof(VERIFY_SIZES[0]);
+    int num_thread_counts = sizeof(VERIFY_THREADS) / sizeof(VERIFY_THREADS[0]);
+    int failures = 0;
+
+    for (int s = 0; s < num_sizes; ++s) {
+        setGridSize(VERIFY_SIZES[s][0], VERIFY_SIZES[s][1]);
+        int cells = (GRID_HEIGHT + 2) * PITCH;
+
+        // Record the reference hash of every generation once per size
+        std::vector<uint64_t> expected(generations + 1);
+        Grid ref_current(cells, 0), ref_next(cells, 0);
+        seedRandomGrid(ref_current, seed);
+        expected[0] = hashGrid(ref_current);
+        for (int g = 1; g <= generations; ++g) {
+            // Float sums depend on the order of the additions, so continuous
+            // rules check the threaded backends against the sequential one
+            if (RULE.continuous)
+                updateGrid(&BACKENDS[0], ref_current, ref_next);
+            else
+                updateGridReference(ref_current, ref_next);
+            std::swap(ref_current, ref_next);
+            expected[g] = hashGrid(ref_current);
+        }
+
+        for (int b = 0; b < NUM_BACKENDS; ++b) {
+            // Single-threaded backends only need one run per size
+            int runs = BACKENDS[b].thread_label ? num_thread_counts : 1;
+            for (int t = 0; t < runs; ++t) {
+                NUM_THREADS = VERIFY_THREADS[t];
+                Grid grid_current(cells, 0), grid_next(cells, 0);
+                seedRandomGrid(grid_current, seed);
+                for (int g = 1; g <= generations; ++g) {
+                    updateGrid(&BACKENDS[b], grid_current, grid_next);
+                    std::swap(grid_current, grid_next);
+                    if (hashGrid(grid_current) != expected[g]) {
+                        std::cerr << "MISMATCH: " << BACKENDS[b].name << " (" << RULE.name << ") on " << GRID_WIDTH << "x" << GRID_HEIGHT
+                                  << " with " << NUM_THREADS << " threads at generation " << g << std::endl;
+                        ++failures;
+                        break;
+                    }
+                }
+
+                // Backends that overlap generations are also checked on batches of every length up to seven
+                if (!BACKENDS[b].run_generations)
+                    continue;
+                seedRandomGrid(grid_current, seed);
+                for (int g = 0, batch = 1; g < generations; batch = batch % 7 + 1) {
+                    batch = std::min(batch, generations - g);
+                    advanceGrid(&BACKENDS[b], grid_current, grid_next, batch);
+                    std::swap(grid_current, grid_next);
+                    g += batch;
+                    if (hashGrid(grid_current) != expected[g]) {
+                        std::cerr << "MISMATCH: " << BACKENDS[b].name << " (" << RULE.name << ") on " << GRID_WIDTH << "x" << GRID_HEIGHT
+                                  << " with " << NUM_THREADS << " threads after " << g << " generations in batches" << std::endl;
+                        ++failures;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    NUM_THREADS = saved_threads;
+    std::cout << (failures ? "FAIL" : "PASS") << ": " << RULE.name << ", " << NUM_BACKENDS << " backends, " << num_sizes << " grid sizes, "
+              << generations << " generations, seed " << seed << std::endl;
+
+    // The backends share one FFT, so it is checked against direct convolution separately
+    bool convolution = !RULE.continuous || RULE.range <= LENIA_DIRECT_RANGE || verifyLeniaConvolution(generations, seed);
+    setGridSize(saved_width, saved_height);
+    return failures == 0 && convolution;
+}
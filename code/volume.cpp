@@ -0,0 +1,435 @@
+/*
+Description:
+Voxel storage, seeding and the two 3D kernels: a byte kernel and a
+bit-packed kernel that counts 26 neighbors of 64 cells at once.
+*/
+
+#include "volume.h"
+#include "rules.h"
+#include "density.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+int GRID_DEPTH = 64;
+int VOLUME_SLICE = 32;
+
+// Volume storage, reallocated whenever the grid size changes. Both layouts
+// have one dead plane, row and column of padding on every side.
+static int cached_width = -1, cached_height = -1, cached_depth = -1;
+static Grid voxels_current, voxels_next;                 // Byte layout: (GRID_DEPTH + 2) planes of (GRID_HEIGHT + 2) rows of PITCH
+static std::vector<uint64_t> words_current, words_next;  // Bit-packed layout: the same planes and rows of WORD_PITCH words
+static int WORD_PITCH = 0;                               // Words per row, bit x % 64 of word 1 + x / 64 is cell x
+static bool state_packed = false;                        // The bit-packed layout holds the current state
+
+static size_t voxelIndex(int z, int y, int x) {
+    return (static_cast<size_t>(z) * (GRID_HEIGHT + 2) + y) * PITCH + x;
+}
+
+static size_t wordIndex(int z, int y, int i) {
+    return (static_cast<size_t>(z) * (GRID_HEIGHT + 2) + y) * WORD_PITCH + i;
+}
+
+static void resizeVolume() {
+    if (cached_width == GRID_WIDTH && cached_height == GRID_HEIGHT && cached_depth == GRID_DEPTH)
+        return;
+    cached_width = GRID_WIDTH;
+    cached_height = GRID_HEIGHT;
+    cached_depth = GRID_DEPTH;
+    size_t cells = static_cast<size_t>(GRID_DEPTH + 2) * (GRID_HEIGHT + 2) * PITCH;
+    voxels_current = Grid(cells);
+    voxels_next = Grid(cells);
+    WORD_PITCH = (GRID_WIDTH + 63) / 64 + 2;
+    words_current.clear();  // Allocated on first use
+    words_next.clear();
+    state_packed = false;
+}
+
+static void packRow(const uint8_t* cells, uint64_t* words) {
+    for (int i = 1; i < WORD_PITCH - 1; ++i) {
+        uint64_t word = 0;
+        int x0 = (i - 1) * 64;
+        for (int b = 0; b < 64 && x0 + b < GRID_WIDTH; ++b)
+            word |= static_cast<uint64_t>(cells[x0 + b + 1] == 1) << b;
+        words[i] = word;
+    }
+}
+
+static void unpackRow(const uint64_t* words, uint8_t* cells) {
+    for (int x = 0; x < GRID_WIDTH; ++x)
+        cells[x + 1] = (words[1 + x / 64] >> (x % 64)) & 1;
+}
+
+/*
+Moves the current state into the byte or the bit-packed layout, converting
+planes in parallel on the backend.
+*/
+static void convertVolume(const Backend* backend, bool packed) {
+    if (state_packed == packed)
+        return;
+    if (packed && words_current.empty()) {
+        words_current.assign(static_cast<size_t>(GRID_DEPTH + 2) * (GRID_HEIGHT + 2) * WORD_PITCH, 0);
+        words_next.assign(words_current.size(), 0);
+    }
+    backend->run_rows(1, GRID_DEPTH + 1, [&](int z_begin, int z_end) {
+        for (int z = z_begin; z < z_end; ++z) {
+            for (int y = 1; y <= GRID_HEIGHT; ++y) {
+                if (packed)
+                    packRow(&voxels_current[voxelIndex(z, y, 0)], &words_current[wordIndex(z, y, 0)]);
+                else
+                    unpackRow(&words_current[wordIndex(z, y, 0)], &voxels_current[voxelIndex(z, y, 0)]);
+            }
+        }
+    });
+    state_packed = packed;
+}
+
+/*
+Parses a 3D rule in Bays' notation: 3D followed by four digits
+E_l E_u F_l F_u, so a live cell survives with E_l to E_u of its 26
+neighbors alive and a dead cell is born with F_l to F_u (3D4555, 3D5766).
+The bit-packed kernel is used unless /BYTE is appended (3D4555/BYTE).
+
+Parameters:
+- spec: Rule string.
+- rule: Rule to fill in.
+
+Returns:
+- true if the string was a valid 3D rule.
+*/
+bool parseVolumeRule(const std::string& spec, Rule& rule) {
+    std::string upper;
+    for (char c : spec)
+        upper += static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+    if (upper.compare(0, 2, "3D") != 0)
+        return false;
+
+    Rule parsed;
+    std::string digits = upper.substr(2);
+    size_t slash = digits.find('/');
+    parsed.packed = slash == std::string::npos;
+    if (!parsed.packed) {
+        if (digits.substr(slash + 1) != "BYTE")
+            return false;
+        digits = digits.substr(0, slash);
+    }
+    if (digits.size() != 4 || digits.find_first_not_of("0123456789") != std::string::npos)
+        return false;
+    int survive_min = digits[0] - '0', survive_max = digits[1] - '0';
+    int birth_min = digits[2] - '0', birth_max = digits[3] - '0';
+    if (survive_min > survive_max || birth_min > birth_max || birth_min == 0)
+        return false;  // Empty ranges, or B0 which would turn the unbounded dead region alive
+
+    parsed.volume = true;
+    parsed.max_neighbors = 26;
+    parsed.birth.assign(27, 0);
+    parsed.survive.assign(27, 0);
+    for (int n = birth_min; n <= birth_max; ++n)
+        parsed.birth[n] = 1;
+    for (int n = survive_min; n <= survive_max; ++n)
+        parsed.survive[n] = 1;
+    parsed.table.assign(2 * 27, 0);
+    for (int n = 0; n <= 26; ++n) {
+        parsed.table[n] = parsed.birth[n];
+        parsed.table[27 + n] = parsed.survive[n];
+    }
+    parsed.name = "3D" + digits + (parsed.packed ? "" : "/BYTE");
+    parsed.update = updateVolume;
+    rule = parsed;
+    return true;
+}
+
+/*
+Seeds the volume with random cells. Each row of each plane draws from its
+own stream derived from the seed, so the volume does not depend on the
+thread split. Only the central half of the volume along every axis is
+filled, which leaves room for patterns to grow before they reach the
+edges.
+
+Parameters:
+- seed: Seed for the random number generator.
+
+Returns:
+- void
+*/
+void seedVolume(uint64_t seed) {
+    resizeVolume();
+    state_packed = false;
+    std::fill(voxels_current.begin(), voxels_current.end(), 0);
+    int x0 = GRID_WIDTH / 4, x1 = GRID_WIDTH - GRID_WIDTH / 4;
+    int y0 = GRID_HEIGHT / 4, y1 = GRID_HEIGHT - GRID_HEIGHT / 4;
+    int z0 = GRID_DEPTH / 4, z1 = GRID_DEPTH - GRID_DEPTH / 4;
+
+    #pragma omp parallel for schedule(static) num_threads(NUM_THREADS)
+    for (int z = z0; z < z1; ++z) {
+        for (int y = y0; y < y1; ++y) {
+            uint64_t state = seed ^ ((static_cast<uint64_t>(z) * GRID_HEIGHT + y + 1) * 0xD1B54A32D192ED03ULL);
+            uint8_t* row = &voxels_current[voxelIndex(z + 1, y + 1, 1)];
+            uint64_t bits = 0;
+            for (int x = x0; x < x1; ++x) {
+                if ((x - x0) % 64 == 0)
+                    bits = splitmix64(state);  // Refill 64 random bits
+                row[x] = bits & 1;
+                bits >>= 1;
+            }
+        }
+    }
+}
+
+/*
+Applies the active 3D rule to a slab of planes with the byte kernel. Each
+row is done in two passes like the Generations kernel: first the nine cells
+above, beside and below every column are summed, then each cell adds the
+sums of its left and right columns and looks its next state up.
+
+Parameters:
+- z_begin: First padded plane to compute.
+- z_end: Padded plane after the last one to compute.
+
+Returns:
+- void
+*/
+static void updateSlabBytes(int z_begin, int z_end) {
+    const uint8_t* table = RULE.table.data();
+    std::vector<uint8_t> column(PITCH);  // Live cells in each padded column of the 3x3 rows around the row
+    for (int z = z_begin; z < z_end; ++z) {
+        for (int y = 1; y <= GRID_HEIGHT; ++y) {
+            const uint8_t* rows[9];
+            for (int r = 0; r < 9; ++r)
+                rows[r] = &voxels_current[voxelIndex(z + r / 3 - 1, y + r % 3 - 1, 0)];
+            uint8_t* sums = column.data();
+            #pragma omp simd
+            for (int x = 0; x < PITCH; ++x)
+                sums[x] = rows[0][x] + rows[1][x] + rows[2][x] + rows[3][x] + rows[4][x]
+                        + rows[5][x] + rows[6][x] + rows[7][x] + rows[8][x];
+
+            const uint8_t* mid = rows[4];
+            uint8_t* out = &voxels_next[voxelIndex(z, y, 0)];
+            #pragma omp simd
+            for (int x = 1; x <= GRID_WIDTH; ++x) {
+                int neighbors = sums[x - 1] + sums[x] + sums[x + 1] - mid[x];
+                out[x] = table[mid[x] * 27 + neighbors];
+            }
+        }
+    }
+}
+
+/*
+Adds up the nine cells of one column position across three planes and three
+rows for 64 columns at once. The result is four bit planes of a count from
+0 to 9.
+*/
+static void sumColumns(const uint64_t* const rows[9], int i, uint64_t count[4]) {
+    uint64_t ones[3], twos[3];
+    for (int r = 0; r < 3; ++r) {  // Full adder over the three planes of each row
+        uint64_t a = rows[r][i], b = rows[r + 3][i], c = rows[r + 6][i];
+        ones[r] = a ^ b ^ c;
+        twos[r] = (a & b) | (c & (a ^ b));
+    }
+    uint64_t carry_ones = (ones[0] & ones[1]) | (ones[2] & (ones[0] ^ ones[1]));
+    uint64_t twos_sum = twos[0] ^ twos[1] ^ twos[2];
+    uint64_t carry_twos = (twos[0] & twos[1]) | (twos[2] & (twos[0] ^ twos[1]));
+    count[0] = ones[0] ^ ones[1] ^ ones[2];
+    count[1] = twos_sum ^ carry_ones;
+    uint64_t carry = twos_sum & carry_ones;
+    count[2] = carry_twos ^ carry;
+    count[3] = carry_twos & carry;
+}
+
+/*
+Applies the active 3D rule to a slab of planes with the bit-packed kernel.
+Each word holds 64 cells of a row. The column sums of the current word are
+shifted by one cell in both directions (taking the edge bit from the
+neighboring words) and added in bit-sliced full adders, giving the count of
+live cells in each 3x3x3 block as five bit planes. The next state is then
+a comparison of those planes against the counts of the rule, so a word of
+64 cells costs about a hundred logic operations.
+
+Parameters:
+- z_begin: First padded plane to compute.
+- z_end: Padded plane after the last one to compute.
+
+Returns:
+- void
+*/
+static void updateSlabPacked(int z_begin, int z_end) {
+    const int words = WORD_PITCH - 2;
+    const uint64_t last_mask = (GRID_WIDTH % 64) ? ~0ULL >> (64 - GRID_WIDTH % 64) : ~0ULL;
+
+    // Block totals (the cell included) that leave the cell alive
+    std::vector<int> alive_totals, dead_totals;
+    for (int n = 0; n <= 26; ++n) {
+        if (RULE.survive[n])
+            alive_totals.push_back(n + 1);
+        if (RULE.birth[n])
+            dead_totals.push_back(n);
+    }
+    auto matches = [](const uint64_t total[5], const std::vector<int>& counts) {
+        uint64_t match = 0;
+        for (int n : counts) {
+            uint64_t equal = ~0ULL;
+            for (int j = 0; j < 5; ++j)
+                equal &= ((n >> j) & 1) ? total[j] : ~total[j];
+            match |= equal;
+        }
+        return match;
+    };
+
+    for (int z = z_begin; z < z_end; ++z) {
+        for (int y = 1; y <= GRID_HEIGHT; ++y) {
+            const uint64_t* rows[9];  // Rows y - 1 to y + 1 of planes z - 1, z and z + 1
+            for (int r = 0; r < 9; ++r)
+                rows[r] = &words_current[wordIndex(z + r / 3 - 1, y + r % 3 - 1, 0)];
+            const uint64_t* mid = rows[4];
+            uint64_t* out = &words_next[wordIndex(z, y, 0)];
+
+            uint64_t previous[4] = {0, 0, 0, 0}, current[4], next[4];
+            sumColumns(rows, 1, current);
+            for (int i = 1; i <= words; ++i) {
+                if (i < words)
+                    sumColumns(rows, i + 1, next);
+                else
+                    std::fill(next, next + 4, 0);
+
+                // Carry-save add of the left, center and right column sums
+                uint64_t sum[4], carry[4];
+                for (int j = 0; j < 4; ++j) {
+                    uint64_t left = (current[j] << 1) | (previous[j] >> 63);
+                    uint64_t right = (current[j] >> 1) | (next[j] << 63);
+                    sum[j] = left ^ current[j] ^ right;
+                    carry[j] = (left & current[j]) | (right & (left ^ current[j]));
+                }
+                uint64_t total[5];
+                total[0] = sum[0];
+                uint64_t ripple = 0;
+                for (int j = 1; j < 4; ++j) {
+                    total[j] = sum[j] ^ carry[j - 1] ^ ripple;
+                    ripple = (sum[j] & carry[j - 1]) | (ripple & (sum[j] ^ carry[j - 1]));
+                }
+                total[4] = carry[3] ^ ripple;
+
+                uint64_t live = (mid[i] & matches(total, alive_totals)) | (~mid[i] & matches(total, dead_totals));
+                out[i] = (i == words) ? live & last_mask : live;
+
+                std::copy(current, current + 4, previous);
+                std::copy(next, next + 4, current);
+            }
+        }
+    }
+}
+
+/*
+Computes one generation of the volume, splitting the planes into slabs
+among the backend's threads.
+
+Parameters:
+- backend: Backend that runs the slabs.
+- packed: true for the bit-packed kernel, false for the byte kernel.
+
+Returns:
+- void
+*/
+void stepVolume(const Backend* backend, bool packed) {
+    resizeVolume();
+    convertVolume(backend, packed);
+    backend->run_rows(1, GRID_DEPTH + 1, [&](int z_begin, int z_end) {
+        if (packed)
+            updateSlabPacked(z_begin, z_end);
+        else
+            updateSlabBytes(z_begin, z_end);
+    });
+    if (packed)
+        words_current.swap(words_next);
+    else
+        voxels_current.swap(voxels_next);
+}
+
+/*
+Copies the current volume in the padded byte layout.
+*/
+void copyVoxels(Grid& voxels) {
+    voxels = voxels_current;
+    if (!state_packed)
+        return;
+    for (int z = 1; z <= GRID_DEPTH; ++z) {
+        for (int y = 1; y <= GRID_HEIGHT; ++y)
+            unpackRow(&words_current[wordIndex(z, y, 0)], &voxels[voxelIndex(z, y, 0)]);
+    }
+}
+
+/*
+Computes a 64-bit FNV-1a hash of the interior cells of a volume in the
+padded byte layout.
+*/
+uint64_t hashVoxels(const Grid& voxels) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (int z = 1; z <= GRID_DEPTH; ++z) {
+        for (int y = 1; y <= GRID_HEIGHT; ++y) {
+            const uint8_t* row = &voxels[voxelIndex(z, y, 1)];
+            for (int x = 0; x < GRID_WIDTH; ++x) {
+                hash ^= row[x];
+                hash *= 0x100000001B3ULL;
+            }
+        }
+    }
+    return hash;
+}
+
+/*
+Copies one slice of the volume into a 2D grid.
+
+Parameters:
+- z: Slice (0-based).
+- grid: Reference to the grid to fill.
+
+Returns:
+- void
+*/
+void readVolumeSlice(int z, Grid& grid) {
+    for (int y = 1; y <= GRID_HEIGHT; ++y) {
+        if (state_packed)
+            unpackRow(&words_current[wordIndex(z + 1, y, 0)], &grid[y * PITCH]);
+        else
+            std::memcpy(&grid[y * PITCH + 1], &voxels_current[voxelIndex(z + 1, y, 1)], GRID_WIDTH);
+    }
+}
+
+/*
+Stores a 2D grid into one slice of the volume, so cells painted in the
+window become part of it.
+
+Parameters:
+- z: Slice (0-based).
+- grid: Reference to the grid holding the slice.
+
+Returns:
+- void
+*/
+void writeVolumeSlice(int z, const Grid& grid) {
+    for (int y = 1; y <= GRID_HEIGHT; ++y) {
+        if (state_packed)
+            packRow(&grid[y * PITCH], &words_current[wordIndex(z + 1, y, 0)]);
+        else
+            std::memcpy(&voxels_current[voxelIndex(z + 1, y, 1)], &grid[y * PITCH + 1], GRID_WIDTH);
+    }
+}
+
+/*
+Computes one generation of the volume for the window and the exporter. The
+grid holds the slice on display: it is stored into the volume first to pick
+up painted cells, and the same slice of the next generation is copied out.
+
+Parameters:
+- backend: Backend that runs the slabs.
+- grid_current: Reference to the current slice.
+- grid_next: Reference to the grid where the next slice will be stored.
+
+Returns:
+- void
+*/
+void updateVolume(const Backend* backend, Grid& grid_current, Grid& grid_next) {
+    writeVolumeSlice(VOLUME_SLICE, grid_current);
+    stepVolume(backend, RULE.packed);
+    readVolumeSlice(VOLUME_SLICE, grid_next);
+    reportChangedCells(grid_current, grid_next, 1, GRID_HEIGHT + 1);
+}
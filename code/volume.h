@@ -0,0 +1,29 @@
+/*
+Description:
+Three-dimensional cellular automata on a padded voxel grid, displayed one
+z slice at a time through the 2D grid.
+*/
+
+#ifndef VOLUME_H
+#define VOLUME_H
+
+#include "life.h"
+#include <string>
+
+struct Rule;
+
+// Volume depth and the slice shown in the window (set from the command line in main)
+extern int GRID_DEPTH;
+extern int VOLUME_SLICE;
+
+// Function Prototypes
+bool parseVolumeRule(const std::string& spec, Rule& rule);
+void seedVolume(uint64_t seed);
+void stepVolume(const Backend* backend, bool packed);
+void copyVoxels(Grid& voxels);
+uint64_t hashVoxels(const Grid& voxels);
+void readVolumeSlice(int z, Grid& grid);
+void writeVolumeSlice(int z, const Grid& grid);
+void updateVolume(const Backend* backend, Grid& grid_current, Grid& grid_next);
+
+#endif
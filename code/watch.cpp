@@ -0,0 +1,137 @@
+/*
+Description:
+LifeWatch, a monitor that attaches to the shared-memory live view of a
+running simulation (Lab2 -m name) and prints each new frame's generation,
+size, occupied cells and checksum, optionally with a text thumbnail.
+Frames are read in place, without copying the grid out of the segment.
+*/
+
+#include "shm.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+#include <algorithm>
+#include <unistd.h>
+
+// Frame statistics gathered by one zero-copy read
+struct FrameSummary {
+    int64_t generation = -1;
+    int width = 0, height = 0;
+    long long occupied = 0;        // Cells with a nonzero state
+    uint64_t checksum = 0;
+    bool checksum_ok = false;      // Cells match the checksum the writer stored
+    std::vector<std::string> thumbnail;
+};
+
+/*
+Summarizes the frame in place: counts occupied cells, checks the checksum
+and, if requested, draws a thumbnail where every character covers a block
+of cells and shows '#' if any of them is occupied.
+
+Parameters:
+- frame: Frame fields read under the sequence lock.
+- columns: Thumbnail width in characters, 0 for none.
+- summary: Reference to the summary to fill.
+
+Returns:
+- void
+*/
+static void summarize(const SharedGridFrame& frame, int columns, FrameSummary& summary) {
+    summary.generation = frame.generation;
+    summary.width = frame.width;
+    summary.height = frame.height;
+    summary.occupied = 0;
+    size_t cells = static_cast<size_t>(frame.width) * frame.height;
+    for (size_t i = 0; i < cells; ++i)
+        summary.occupied += frame.cells[i] != 0;
+    summary.checksum = frame.checksum;
+    summary.checksum_ok = sharedGridChecksum(frame.cells, cells) == frame.checksum;
+
+    summary.thumbnail.clear();
+    if (columns <= 0 || frame.width <= 0)
+        return;
+    int block = (frame.width + columns - 1) / columns;
+    int block_rows = 2 * block;  // Characters are about twice as tall as they are wide
+    for (int y0 = 0; y0 < frame.height; y0 += block_rows) {
+        std::string line;
+        for (int x0 = 0; x0 < frame.width; x0 += block) {
+            bool any = false;
+            for (int y = y0; y < std::min(frame.height, y0 + block_rows) && !any; ++y)
+                for (int x = x0; x < std::min(frame.width, x0 + block) && !any; ++x)
+                    any = frame.cells[static_cast<size_t>(y) * frame.width + x] != 0;
+            line += any ? '#' : '.';
+        }
+        summary.thumbnail.push_back(line);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    int opt;
+    int interval_ms = 500;  // Time between frames
+    int columns = 0;        // Thumbnail width, 0 prints no thumbnail
+    long long frames = 0;   // Frames to print, 0 runs until the simulation ends
+    while ((opt = getopt(argc, argv, "i:c:n:")) != -1) {
+        switch (opt) {
+            case 'i':
+                interval_ms = std::max(1, std::atoi(optarg));  // Set the polling interval in milliseconds
+                break;
+            case 'c':
+                columns = std::max(0, std::atoi(optarg));  // Set the thumbnail width
+                break;
+            case 'n':
+                frames = std::max(0, std::atoi(optarg));  // Set the number of frames to print
+                break;
+            default:
+                std::cerr << "Usage: " << argv[0] << " [-i interval_ms] [-c thumbnail_columns] [-n frames] shm_name\n";
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc) {
+        std::cerr << "Usage: " << argv[0] << " [-i interval_ms] [-c thumbnail_columns] [-n frames] shm_name\n";
+        return EXIT_FAILURE;
+    }
+    std::string name = argv[optind][0] == '/' ? argv[optind] : std::string("/") + argv[optind];
+
+    SharedGridReader reader;
+    if (!reader.attach(name)) {
+        std::cerr << "Cannot attach to " << name << ". Start the simulation with -m " << name << " first." << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    int64_t last_generation = -1;
+    uint64_t last_checksum = 0;
+    auto last_change = std::chrono::steady_clock::now();
+    for (long long printed = 0; frames == 0 || printed < frames;) {
+        FrameSummary summary;
+        bool consistent = false;
+        for (int attempt = 0; attempt < 100 && !consistent; ++attempt)
+            consistent = reader.read([&](const SharedGridFrame& frame) { summarize(frame, columns, summary); });
+
+        auto now = std::chrono::steady_clock::now();
+        // Edits while the simulation is paused change the cells but not the generation
+        if (consistent && (summary.generation != last_generation || summary.checksum != last_checksum)) {
+            std::cout << "gen " << summary.generation << "  " << summary.width << "x" << summary.height << "  occupied "
+                      << summary.occupied << "  checksum " << (summary.checksum_ok ? "ok" : "MISMATCH") << std::endl;
+            for (const std::string& line : summary.thumbnail)
+                std::cout << line << '\n';
+            last_generation = summary.generation;
+            last_checksum = summary.checksum;
+            last_change = now;
+            ++printed;
+        } else if (now - last_change >= std::chrono::seconds(2)) {
+            // A quiet segment may belong to a finished run; stop once its name is gone
+            int fd = shm_open(name.c_str(), O_RDONLY, 0);
+            if (fd < 0) {
+                std::cout << "Simulation ended." << std::endl;
+                break;
+            }
+            close(fd);
+            last_change = now;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(interval_ms));
+    }
+    return EXIT_SUCCESS;
+}